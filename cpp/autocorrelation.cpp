@@ -0,0 +1,117 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "autocorrelation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <boost/thread/mutex.hpp>
+
+#include "psd_engine.h"
+
+Autocorrelation::Autocorrelation() :
+    fftSz_(0),
+    complex_(false),
+    plan_(NULL)
+{
+}
+
+Autocorrelation::~Autocorrelation(){
+    release();
+}
+
+bool Autocorrelation::matches(size_t fftSize, bool complex) const{
+    return plan_ && fftSize == fftSz_ && complex == complex_;
+}
+
+void Autocorrelation::configure(size_t fftSize, bool complex){
+    if (matches(fftSize, complex))
+        return;
+    release();
+    fftSz_ = fftSize;
+    complex_ = complex;
+
+    int n = fftSz_;
+    boost::mutex::scoped_lock lock(PsdEngine::planLock());
+    if (complex_) {
+        spectrum_.resize(fftSz_);
+        complexOut_.resize(fftSz_);
+        plan_ = fftwf_plan_dft_1d(n, reinterpret_cast<fftwf_complex*>(&spectrum_[0]),
+                                  reinterpret_cast<fftwf_complex*>(&complexOut_[0]),
+                                  FFTW_BACKWARD, FFTW_MEASURE);
+    } else {
+        spectrum_.resize(fftSz_/2+1);
+        realOut_.resize(fftSz_);
+        plan_ = fftwf_plan_dft_c2r_1d(n, reinterpret_cast<fftwf_complex*>(&spectrum_[0]),
+                                      &realOut_[0], FFTW_MEASURE);
+    }
+}
+
+void Autocorrelation::release(){
+    if (plan_) {
+        boost::mutex::scoped_lock lock(PsdEngine::planLock());
+        fftwf_destroy_plan(plan_);
+        plan_ = NULL;
+    }
+    ComplexHugeVector().swap(spectrum_);
+    ComplexHugeVector().swap(complexOut_);
+    RealHugeVector().swap(realOut_);
+}
+
+void Autocorrelation::transform(const float* psd, float logCoeff, size_t frameLength, float* lags){
+    const size_t n = fftSz_;
+    const size_t half = n/2;
+    std::complex<float>* spectrum = &spectrum_[0];
+
+    // the power spectrum in natural order (DC first).  the centered
+    // complex layout has DC at half, so the two halves swap over
+    if (complex_) {
+        for (size_t k=0; k<n-half; k++)
+            spectrum[k] = psd[k+half];
+        for (size_t k=n-half; k<n; k++)
+            spectrum[k] = psd[k+half-n];
+    } else {
+        for (size_t k=0; k<=half; k++)
+            spectrum[k] = psd[k];
+    }
+    if (logCoeff > 0) {
+        for (size_t k=0; k<spectrum_.size(); k++)
+            spectrum[k] = std::pow(10.0f, spectrum[k].real()/logCoeff);
+    }
+
+    fftwf_execute(plan_);
+
+    // the unnormalized inverse of |X|^2 is n times the sum of lagged
+    // products; lag 0 goes in the middle of the output
+    const float scale = 1.0f/(float(n)*std::max<size_t>(frameLength, 1));
+    if (complex_) {
+        const std::complex<float>* r = &complexOut_[0];
+        std::complex<float>* out = reinterpret_cast<std::complex<float>*>(lags);
+        for (size_t j=0; j<half; j++)
+            out[j] = r[j+n-half]*scale;
+        for (size_t j=half; j<n; j++)
+            out[j] = r[j-half]*scale;
+    } else {
+        const float* r = &realOut_[0];
+        for (size_t j=0; j<half; j++)
+            lags[j] = r[j+n-half]*scale;
+        for (size_t j=half; j<n; j++)
+            lags[j] = r[j-half]*scale;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef AUTOCORRELATION_H
+#define AUTOCORRELATION_H
+
+#include <cstddef>
+
+#include <fftw3.h>
+#include "huge_pages.h"
+
+class Autocorrelation
+{
+    //autocorrelation from a psd by the Wiener-Khinchin theorem: the inverse
+    //fft of the power spectrum of a frame is its (circular) autocorrelation,
+    //so an averaged psd gives the averaged autocorrelation in O(N log N)
+    //
+    //the psd is laid out like PsdEngine's output (complex input centered on
+    //DC).  for lags free of circular wrap, the frames must have been zero
+    //padded to at least twice their length before the forward transform
+public:
+    Autocorrelation();
+    ~Autocorrelation();
+
+    // builds the inverse transform for psds of an fftSize-point transform
+    void configure(size_t fftSize, bool complex);
+    void release();
+
+    bool matches(size_t fftSize, bool complex) const;
+    // fftSize lags: real values for real input, interleaved complex pairs
+    // for complex input
+    size_t outputLength() const { return complex_ ? 2*fftSz_ : fftSz_; }
+
+    // lags from -fftSize/2 to fftSize/2-1.  logCoeff is that of the psd
+    // (0 for linear power).  the result is divided by frameLength, the
+    // samples per frame before padding, so that lag 0 is the mean power
+    void transform(const float* psd, float logCoeff, size_t frameLength, float* lags);
+
+private:
+    Autocorrelation(const Autocorrelation&);
+    Autocorrelation& operator=(const Autocorrelation&);
+
+    size_t fftSz_;
+    bool complex_;
+    fftwf_plan plan_;
+    ComplexHugeVector spectrum_;
+    ComplexHugeVector complexOut_;
+    RealHugeVector realOut_;
+};
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "band_power.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+bool BandPower::binRange(double start, double stop, size_t bins, size_t& first, size_t& last){
+    double lower = std::max(std::ceil(start), 0.0);
+    double upper = std::min(std::floor(stop)+1, double(bins));
+    if (!(upper > lower))
+        return false;
+    first = size_t(lower);
+    last = size_t(upper);
+    return true;
+}
+
+bool BandPower::configure(const std::vector<double>& starts, const std::vector<double>& stops, size_t bins){
+    bins_ = bins;
+    first_.clear();
+    last_.clear();
+    bool all = true;
+    for (size_t i=0; i<starts.size() && i<stops.size(); i++) {
+        size_t first, last;
+        if (!binRange(starts[i], stops[i], bins, first, last)) {
+            all = false;
+            continue;
+        }
+        first_.push_back(first);
+        last_.push_back(last);
+    }
+    return all;
+}
+
+void BandPower::compute(const float* psd, float logCoeff, float* power){
+    // running sums in double precision: the difference of two large sums
+    // would otherwise lose the power of a weak band
+    const size_t bins = bins_;
+    sums_.resize(bins+1);
+    double* sums = &sums_[0];
+    sums[0] = 0;
+    if (logCoeff > 0) {
+        for (size_t i=0; i<bins; i++)
+            sums[i+1] = sums[i] + std::pow(10.0, psd[i]/logCoeff);
+    } else {
+        for (size_t i=0; i<bins; i++)
+            sums[i+1] = sums[i] + psd[i];
+    }
+
+    for (size_t i=0; i<first_.size(); i++) {
+        double total = sums[last_[i]] - sums[first_[i]];
+        if (logCoeff > 0) {
+            // a band of all-zero bins would otherwise give -inf
+            power[i] = logCoeff*std::log10(std::max(total, double(FLT_MIN)));
+        } else {
+            power[i] = total;
+        }
+    }
+}
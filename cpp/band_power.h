@@ -0,0 +1,56 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef BAND_POWER_H
+#define BAND_POWER_H
+
+#include <cstddef>
+#include <vector>
+
+class BandPower
+{
+    //total power in each of a list of frequency bands of a psd frame
+    //
+    //one pass accumulates the power over the bins; the sum over any band
+    //is then the difference of two of those running sums, so the cost is
+    //O(bins + bands) however many bands there are or how they overlap
+public:
+    // the bins [first, last) of a psd of bins elements whose centers fall
+    // within a band given by its first and last bin position (which may be
+    // fractional); false if there are none
+    static bool binRange(double start, double stop, size_t bins, size_t& first, size_t& last);
+
+    // bands for a psd of bins elements.  every band must cover at least one
+    // bin (see binRange()); any that do not are dropped, and false returned
+    bool configure(const std::vector<double>& starts, const std::vector<double>& stops, size_t bins);
+    size_t bands() const { return first_.size(); }
+
+    // power of each band (bands() elements) from a psd of the configured
+    // length.  logCoeff is that of the psd (0 for linear power); the
+    // results are in the same units
+    void compute(const float* psd, float logCoeff, float* power);
+
+private:
+    // bin range [first, last) of each band
+    std::vector<size_t> first_;
+    std::vector<size_t> last_;
+    size_t bins_;
+    std::vector<double> sums_;
+};
+
+#endif
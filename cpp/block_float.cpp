@@ -0,0 +1,67 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "block_float.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+namespace blockfloat {
+
+    int exponent(const float* data, size_t count){
+        // for non-negative floats the bit patterns order like the values,
+        // so the peak magnitude is an integer max with the sign bit
+        // cleared; no branches or float compares, so the loop vectorizes
+        uint32_t peak = 0;
+        for (size_t i=0; i<count; i++) {
+            uint32_t bits;
+            memcpy(&bits, &data[i], sizeof(bits));
+            peak = std::max(peak, bits & 0x7fffffffu);
+        }
+        if (peak == 0)
+            return 0;
+        // inf and nan saturate
+        peak = std::min(peak, 0x7f7fffffu);
+        float largest;
+        memcpy(&largest, &peak, sizeof(largest));
+
+        // largest < 2^e2, so dividing by 2^(e2-15) leaves it under 32768;
+        // very small blocks are not scaled up past what a float can hold
+        int e2;
+        std::frexp(largest, &e2);
+        return std::max(e2-15, -126);
+    }
+
+    int convert(const std::complex<float>* data, size_t count, short* out){
+        const float* in = reinterpret_cast<const float*>(data);
+        const size_t n = 2*count;
+        int e = exponent(in, n);
+        const float scale = std::ldexp(1.0f, -e);
+
+        // round to nearest by truncating an offset (always positive) value;
+        // the clamp takes the one rounding case that reaches 32768
+        for (size_t i=0; i<n; i++) {
+            int32_t value = int32_t(in[i]*scale + 32768.5f);
+            value = std::min(std::max(value, 0), 65535);
+            out[i] = short(value - 32768);
+        }
+        return e;
+    }
+}
@@ -0,0 +1,40 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef BLOCK_FLOAT_H
+#define BLOCK_FLOAT_H
+
+#include <complex>
+#include <cstddef>
+
+namespace blockfloat {
+
+    // 16-bit block floating point: a block of values shares one exponent e,
+    // and each value is stored as the int16 nearest to value/2^e.  e is the
+    // smallest that keeps the largest magnitude in range, so the block uses
+    // the full 16 bits whatever its level
+
+    // exponent for a block of count floats
+    int exponent(const float* data, size_t count);
+
+    // convert count complex values to interleaved int16 pairs; returns the
+    // exponent used
+    int convert(const std::complex<float>* data, size_t count, short* out);
+}
+
+#endif
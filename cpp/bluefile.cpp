@@ -0,0 +1,136 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "bluefile.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const size_t HCB_SIZE = BLUE_HCB_SIZE;
+
+    template <typename T>
+    void put(unsigned char* hcb, size_t offset, T value){
+        memcpy(hcb+offset, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T get(const unsigned char* hcb, size_t offset, bool swap){
+        unsigned char bytes[sizeof(T)];
+        memcpy(bytes, hcb+offset, sizeof(T));
+        if (swap)
+            std::reverse(bytes, bytes+sizeof(T));
+        T value;
+        memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    bool bigEndianHost(){
+        const uint16_t probe = 1;
+        return *reinterpret_cast<const unsigned char*>(&probe) == 0;
+    }
+
+    // true if values stored with the given representation need swapping
+    bool needsSwap(const unsigned char* rep){
+        bool bigEndian = (memcmp(rep, "IEEE", 4) == 0);
+        return bigEndian != bigEndianHost();
+    }
+}
+
+BlueHeader::BlueHeader() :
+    type(1000),
+    dataStart(HCB_SIZE),
+    dataSize(0),
+    timecode(0),
+    xstart(0),
+    xdelta(1),
+    xunits(0),
+    subsize(0),
+    ystart(0),
+    ydelta(1),
+    yunits(0),
+    dataSwapped(false)
+{
+    format[0] = 'S';
+    format[1] = 'F';
+}
+
+size_t BlueHeader::elementSize() const {
+    switch (format[1]) {
+        case 'B': return 1;
+        case 'I': return 2;
+        case 'L': return 4;
+        case 'F': return 4;
+        case 'X': return 8;
+        case 'D': return 8;
+        default: return 0;
+    }
+}
+
+bool parseBlueHeader(const unsigned char* hcb, BlueHeader& header){
+    if (memcmp(hcb, "BLUE", 4) != 0)
+        return false;
+
+    bool swap = needsSwap(hcb+4);
+    header.dataSwapped = needsSwap(hcb+8);
+    header.dataStart = get<double>(hcb, 32, swap);
+    header.dataSize = get<double>(hcb, 40, swap);
+    header.type = get<int32_t>(hcb, 48, swap);
+    header.format[0] = hcb[52];
+    header.format[1] = hcb[53];
+    header.timecode = get<double>(hcb, 56, swap);
+
+    header.xstart = get<double>(hcb, 256, swap);
+    header.xdelta = get<double>(hcb, 264, swap);
+    header.xunits = get<int32_t>(hcb, 272, swap);
+    if (header.type/1000 == 2) {
+        header.subsize = get<int32_t>(hcb, 276, swap);
+        header.ystart = get<double>(hcb, 280, swap);
+        header.ydelta = get<double>(hcb, 288, swap);
+        header.yunits = get<int32_t>(hcb, 296, swap);
+    }
+    return true;
+}
+
+bool writeBlueHeader(FILE* fp, const BlueHeader& header){
+    unsigned char hcb[HCB_SIZE];
+    memset(hcb, 0, sizeof(hcb));
+
+    memcpy(hcb+0, "BLUE", 4);
+    memcpy(hcb+4, "EEEI", 4);  // head_rep
+    memcpy(hcb+8, "EEEI", 4);  // data_rep
+    put<double>(hcb, 32, header.dataStart);
+    put<double>(hcb, 40, header.dataSize);
+    put<int32_t>(hcb, 48, header.type);
+    hcb[52] = header.format[0];
+    hcb[53] = header.format[1];
+    put<double>(hcb, 56, header.timecode);
+
+    // adjunct
+    put<double>(hcb, 256, header.xstart);
+    put<double>(hcb, 264, header.xdelta);
+    put<int32_t>(hcb, 272, header.xunits);
+    if (header.type/1000 == 2) {
+        put<int32_t>(hcb, 276, header.subsize);
+        put<double>(hcb, 280, header.ystart);
+        put<double>(hcb, 288, header.ydelta);
+        put<int32_t>(hcb, 296, header.yunits);
+    }
+
+    return fwrite(hcb, 1, sizeof(hcb), fp) == sizeof(hcb);
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef PSD_BLUEFILE_H
+#define PSD_BLUEFILE_H
+
+#include <string>
+#include <cstdio>
+#include <stdint.h>
+
+// Minimal support for the X-Midas BLUE file format.  Only the fields of the
+// header control block (HCB) needed to describe type 1000 (1-D) and type 2000
+// (framed) data are handled.  Files are always written in little-endian
+// ("EEEI") order; either order is accepted when reading.
+
+// offset between the BLUE timecode epoch (J1950) and the unix epoch
+const double BLUE_J1950_OFFSET = 631152000.0;
+
+struct BlueHeader {
+    BlueHeader();
+
+    int type;           // 1000 or 2000
+    char format[2];     // 'S'/'C' followed by 'F','I','D','B'...
+    double dataStart;   // byte offset of the data in the file
+    double dataSize;    // number of data bytes
+    double timecode;    // seconds since J1950 of the first sample
+    double xstart;
+    double xdelta;
+    int xunits;
+    int subsize;        // type 2000 only
+    double ystart;      // type 2000 only
+    double ydelta;      // type 2000 only
+    int yunits;         // type 2000 only
+    bool dataSwapped;   // data is stored big-endian ("IEEE")
+
+    bool complex() const { return format[0] == 'C'; }
+    size_t elementSize() const; // size of one scalar element in bytes
+};
+
+const size_t BLUE_HCB_SIZE = 512;
+
+// parse a 512-byte header control block; returns false if it is not a
+// BLUE header
+bool parseBlueHeader(const unsigned char* hcb, BlueHeader& header);
+
+// write a 512-byte header control block at the current position of fp
+bool writeBlueHeader(FILE* fp, const BlueHeader& header);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <ossie/shared_buffer.h>
+
+#include "huge_pages.h"
+
+template <typename T>
+class BufferPool
+{
+    //recycles fixed-size output buffers so that each frame can be handed to
+    //the output stream as a shared buffer instead of being copied
+    //
+    //buffers are fftw-aligned (and huge-page backed when large and enabled)
+    //so the engine can transform directly into them.  a buffer returns to the pool when the last reference to it is
+    //released, which may be well after the write if a local consumer holds
+    //on to the data.  buffers of a stale size are freed rather than reused
+public:
+    explicit BufferPool(size_t maxFree=8) :
+        state_(new State(maxFree))
+    {
+    }
+
+    redhawk::buffer<T> allocate(size_t size){
+        T* data = 0;
+        {
+            boost::mutex::scoped_lock lock(state_->lock);
+            if (size != state_->size) {
+                state_->clear();
+                state_->size = size;
+            } else if (!state_->free.empty()) {
+                data = state_->free.back();
+                state_->free.pop_back();
+            }
+        }
+        if (!data)
+            data = static_cast<T*>(hugepages::allocate(size*sizeof(T)));
+        return redhawk::buffer<T>(data, size, Recycler(state_, size));
+    }
+
+private:
+    struct State {
+        explicit State(size_t maxFree) : size(0), maxFree(maxFree) {}
+        ~State() { clear(); }
+        void clear(){
+            for (size_t i=0; i<free.size(); i++)
+                hugepages::deallocate(free[i]);
+            free.clear();
+        }
+        boost::mutex lock;
+        size_t size;
+        size_t maxFree;
+        std::vector<T*> free;
+    };
+
+    // deleter for the handed-out buffers; holds the pool state so that
+    // buffers outliving the pool are still freed correctly
+    struct Recycler {
+        Recycler(const boost::shared_ptr<State>& state, size_t size) : state(state), size(size) {}
+        void operator()(T* data) const {
+            {
+                boost::mutex::scoped_lock lock(state->lock);
+                if (size == state->size && state->free.size() < state->maxFree) {
+                    state->free.push_back(data);
+                    return;
+                }
+            }
+            hugepages::deallocate(data);
+        }
+        boost::shared_ptr<State> state;
+        size_t size;
+    };
+
+    boost::shared_ptr<State> state_;
+};
+
+#endif
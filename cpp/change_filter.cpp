@@ -0,0 +1,81 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "change_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+ChangeFilter::ChangeFilter() :
+    threshold_(0),
+    logCoeff_(0),
+    keepAlive_(0),
+    held_(0),
+    valid_(false)
+{
+}
+
+void ChangeFilter::configure(float threshold, float logCoeff, size_t keepAlive){
+    if (threshold != threshold_ || logCoeff != logCoeff_)
+        reset();
+    threshold_ = std::max(threshold, 0.0f);
+    logCoeff_ = logCoeff;
+    keepAlive_ = keepAlive;
+    if (!enabled())
+        std::vector<float>().swap(last_);
+}
+
+void ChangeFilter::reset(){
+    valid_ = false;
+    held_ = 0;
+}
+
+bool ChangeFilter::pass(const float* psd, size_t bins){
+    if (!enabled())
+        return true;
+    bool send = !valid_ || last_.size() != bins || changed(psd, bins);
+    if (!send && keepAlive_ > 0 && held_+1 >= keepAlive_)
+        send = true;
+    if (!send) {
+        held_++;
+        return false;
+    }
+    last_.assign(psd, psd+bins);
+    valid_ = true;
+    held_ = 0;
+    return true;
+}
+
+bool ChangeFilter::changed(const float* psd, size_t bins) const{
+    // the bins past the threshold are counted rather than searched for, so
+    // that the compare has no branches and vectorizes
+    const float* last = &last_[0];
+    size_t count = 0;
+    if (logCoeff_ > 0) {
+        // the psd is logCoeff*log10(power); the difference scales with it
+        const float limit = threshold_*logCoeff_/10.0f;
+        for (size_t i=0; i<bins; i++)
+            count += (std::fabs(psd[i]-last[i]) > limit) ? 1 : 0;
+    } else {
+        // linear power: a ratio past the threshold either way
+        const float ratio = std::pow(10.0f, threshold_/10.0f);
+        for (size_t i=0; i<bins; i++)
+            count += ((psd[i] > last[i]*ratio) | (last[i] > psd[i]*ratio)) ? 1 : 0;
+    }
+    return count > 0;
+}
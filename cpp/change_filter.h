@@ -0,0 +1,58 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef CHANGE_FILTER_H
+#define CHANGE_FILTER_H
+
+#include <cstddef>
+#include <vector>
+
+class ChangeFilter
+{
+    //decides which psd frames are worth sending when the spectrum is mostly
+    //static.  a frame passes if any bin differs from the last frame passed
+    //by more than the threshold, or if keepAlive frames in a row would
+    //otherwise have been held back
+public:
+    ChangeFilter();
+
+    // threshold in dB, 0 to pass every frame.  logCoeff is that of the psd
+    // (0 for linear power).  keepAlive is in frames, 0 for no limit.  a
+    // different threshold or scale passes the next frame
+    void configure(float threshold, float logCoeff, size_t keepAlive);
+    bool enabled() const { return threshold_ > 0; }
+
+    // the next frame passes regardless
+    void reset();
+
+    // true if the frame is to be sent, in which case it becomes the
+    // reference for the following frames
+    bool pass(const float* psd, size_t bins);
+
+private:
+    bool changed(const float* psd, size_t bins) const;
+
+    float threshold_;
+    float logCoeff_;
+    size_t keepAlive_;
+    size_t held_;
+    bool valid_;
+    std::vector<float> last_;
+};
+
+#endif
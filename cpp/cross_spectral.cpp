@@ -0,0 +1,193 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "cross_spectral.h"
+#include "psd_engine.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // sum += a * conj(b) on interleaved complex data; written on plain
+    // floats so the compiler can vectorize it
+    void accumulateCross(const float* __restrict__ a, const float* __restrict__ b,
+                         float* __restrict__ sum, size_t bins){
+        for (size_t i=0; i<2*bins; i+=2) {
+            sum[i]   += a[i]*b[i]   + a[i+1]*b[i+1];
+            sum[i+1] += a[i+1]*b[i] - a[i]*b[i+1];
+        }
+    }
+
+    void accumulateAuto(const float* __restrict__ a, float* __restrict__ sum, size_t bins){
+        for (size_t i=0; i<bins; i++)
+            sum[i] += a[2*i]*a[2*i] + a[2*i+1]*a[2*i+1];
+    }
+}
+
+CrossSpectralEngine::CrossSpectralEngine(size_t channels, size_t fftSize, size_t numAvg) :
+    channels_(channels),
+    fftSz_(fftSize),
+    numAvg_(numAvg),
+    plan_(NULL),
+    planComplex_(false),
+    planSize_(0),
+    bins_(0),
+    avgCount_(0)
+{
+}
+
+CrossSpectralEngine::~CrossSpectralEngine(){
+    destroyPlan();
+}
+
+void CrossSpectralEngine::destroyPlan(){
+    if (plan_) {
+        boost::mutex::scoped_lock lock(PsdEngine::planLock());
+        fftwf_destroy_plan(plan_);
+        plan_ = NULL;
+    }
+}
+
+void CrossSpectralEngine::setFftSize(size_t fftSize){
+    if (fftSize != fftSz_) {
+        fftSz_ = fftSize;
+        avgCount_ = 0;
+    }
+}
+
+void CrossSpectralEngine::setNumAvg(size_t numAvg){
+    if (numAvg != numAvg_) {
+        numAvg_ = numAvg;
+        avgCount_ = 0;
+    }
+}
+
+void CrossSpectralEngine::flush(){
+    avgCount_ = 0;
+}
+
+void CrossSpectralEngine::pair(size_t index, size_t& first, size_t& second) const{
+    first = 0;
+    size_t row = channels_-1;
+    while (index >= row) {
+        index -= row;
+        first++;
+        row--;
+    }
+    second = first+1+index;
+}
+
+void CrossSpectralEngine::setup(bool complex){
+    destroyPlan();
+
+    bins_ = outputLength(complex);
+    spectra_.resize(channels_*bins_);
+    autoSum_.resize(channels_*bins_);
+    crossSum_.resize(pairs()*bins_);
+    csd_.resize(pairs()*bins_);
+    coherence_.resize(pairs()*bins_);
+    avgCount_ = 0;
+
+    int n = fftSz_;
+    boost::mutex::scoped_lock lock(PsdEngine::planLock());
+    if (complex) {
+        RealHugeVector().swap(realIn_);
+        complexIn_.resize(channels_*fftSz_);
+        plan_ = fftwf_plan_many_dft(1, &n, channels_,
+                                    reinterpret_cast<fftwf_complex*>(&complexIn_[0]), NULL, 1, fftSz_,
+                                    reinterpret_cast<fftwf_complex*>(&spectra_[0]), NULL, 1, bins_,
+                                    FFTW_FORWARD, FFTW_MEASURE);
+    } else {
+        ComplexHugeVector().swap(complexIn_);
+        realIn_.resize(channels_*fftSz_);
+        plan_ = fftwf_plan_many_dft_r2c(1, &n, channels_,
+                                        &realIn_[0], NULL, 1, fftSz_,
+                                        reinterpret_cast<fftwf_complex*>(&spectra_[0]), NULL, 1, bins_,
+                                        FFTW_MEASURE);
+    }
+    planComplex_ = complex;
+    planSize_ = fftSz_;
+}
+
+bool CrossSpectralEngine::process(const float* const* data, size_t length, bool complex){
+    length = std::min(length, fftSz_);
+    if (!plan_ || complex != planComplex_ || fftSz_ != planSize_)
+        setup(complex);
+
+    // gather the channels into the batch, zero padding short frames
+    for (size_t ch=0; ch<channels_; ch++) {
+        if (complex) {
+            const std::complex<float>* in = reinterpret_cast<const std::complex<float>*>(data[ch]);
+            std::complex<float>* out = &complexIn_[ch*fftSz_];
+            if (fftSz_ % 2 == 0) {
+                // fftshift by modulation, as in PsdEngine
+                for (size_t i=0; i<length; i++)
+                    out[i] = (i & 1) ? -in[i] : in[i];
+            } else {
+                memcpy(out, in, length*sizeof(std::complex<float>));
+            }
+            std::fill(out+length, out+fftSz_, std::complex<float>(0,0));
+        } else {
+            float* out = &realIn_[ch*fftSz_];
+            memcpy(out, data[ch], length*sizeof(float));
+            std::fill(out+length, out+fftSz_, 0.0f);
+        }
+    }
+    fftwf_execute(plan_);
+    if (complex && fftSz_ % 2 != 0) {
+        for (size_t ch=0; ch<channels_; ch++) {
+            std::complex<float>* spectrum = &spectra_[ch*bins_];
+            std::rotate(spectrum, spectrum+(fftSz_+1)/2, spectrum+fftSz_);
+        }
+    }
+
+    if (avgCount_ == 0) {
+        std::fill(autoSum_.begin(), autoSum_.end(), 0.0f);
+        std::fill(crossSum_.begin(), crossSum_.end(), std::complex<float>(0,0));
+    }
+    const float* spectra = reinterpret_cast<const float*>(&spectra_[0]);
+    float* cross = reinterpret_cast<float*>(&crossSum_[0]);
+    for (size_t ch=0; ch<channels_; ch++)
+        accumulateAuto(spectra+2*ch*bins_, &autoSum_[ch*bins_], bins_);
+    for (size_t p=0; p<pairs(); p++) {
+        size_t first, second;
+        pair(p, first, second);
+        accumulateCross(spectra+2*first*bins_, spectra+2*second*bins_, cross+2*p*bins_, bins_);
+    }
+
+    if (++avgCount_ < std::max<size_t>(numAvg_, 1))
+        return false;
+    float scale = 1.0f/avgCount_;
+    avgCount_ = 0;
+
+    for (size_t p=0; p<pairs(); p++) {
+        size_t first, second;
+        pair(p, first, second);
+        const std::complex<float>* sxy = &crossSum_[p*bins_];
+        const float* sxx = &autoSum_[first*bins_];
+        const float* syy = &autoSum_[second*bins_];
+        std::complex<float>* csd = &csd_[p*bins_];
+        float* coherence = &coherence_[p*bins_];
+        for (size_t i=0; i<bins_; i++) {
+            csd[i] = sxy[i]*scale;
+            float denom = sxx[i]*syy[i];
+            coherence[i] = (denom > 0) ? std::norm(sxy[i])/denom : 0.0f;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef CROSS_SPECTRAL_H
+#define CROSS_SPECTRAL_H
+
+#include <complex>
+
+#include <fftw3.h>
+#include "huge_pages.h"
+
+class CrossSpectralEngine
+{
+    //averaged cross-spectral density and magnitude-squared coherence
+    //between every pair of channels
+    //
+    //one time-aligned frame per channel is transformed with a single batched
+    //plan; the auto and cross spectra are accumulated until numAvg frames
+    //have been seen.  pairs are ordered (0,1), (0,2), ... (1,2), ...
+    //bins are laid out like the PsdEngine output (complex input is centered
+    //on DC)
+public:
+    CrossSpectralEngine(size_t channels, size_t fftSize, size_t numAvg);
+    ~CrossSpectralEngine();
+
+    void setFftSize(size_t fftSize);
+    void setNumAvg(size_t numAvg);
+    size_t fftSize() const { return fftSz_; }
+
+    size_t channels() const { return channels_; }
+    size_t pairs() const { return channels_*(channels_-1)/2; }
+    void pair(size_t index, size_t& first, size_t& second) const;
+    size_t outputLength(bool complex) const { return complex ? fftSz_ : fftSz_/2+1; }
+
+    // drop any partial average
+    void flush();
+
+    // data holds one frame per channel, each length samples (zero padded to
+    // fftSize).  returns true when an averaged csd/coherence frame is ready
+    bool process(const float* const* data, size_t length, bool complex);
+
+    // results of the last completed average
+    const std::complex<float>* csd(size_t pair) const { return &csd_[pair*bins_]; }
+    const float* coherence(size_t pair) const { return &coherence_[pair*bins_]; }
+
+private:
+    CrossSpectralEngine(const CrossSpectralEngine&);
+    CrossSpectralEngine& operator=(const CrossSpectralEngine&);
+
+    void setup(bool complex);
+    void destroyPlan();
+
+    size_t channels_;
+    size_t fftSz_;
+    size_t numAvg_;
+
+    // batched transform of all channels
+    fftwf_plan plan_;
+    bool planComplex_;
+    size_t planSize_;
+    size_t bins_;
+
+    RealHugeVector realIn_;
+    ComplexHugeVector complexIn_;
+    ComplexHugeVector spectra_;
+
+    // running sums, channels x bins and pairs x bins
+    RealHugeVector autoSum_;
+    ComplexHugeVector crossSum_;
+    size_t avgCount_;
+
+    ComplexHugeVector csd_;
+    RealHugeVector coherence_;
+};
+
+#endif
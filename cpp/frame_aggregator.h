@@ -0,0 +1,114 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef FRAME_AGGREGATOR_H
+#define FRAME_AGGREGATOR_H
+
+#include <algorithm>
+#include <boost/thread/thread_time.hpp>
+#include <bulkio/bulkio.h>
+
+#include "buffer_pool.h"
+
+template <typename T>
+class FrameAggregator
+{
+    //packs consecutive output frames of one stream into a single packet to
+    //cut the per-push overhead of small frames
+    //
+    //the frames are laid out back to back, which is exactly what the
+    //output SRI already describes (subsize elements per frame, ydelta
+    //between frames), and the packet carries the first frame's time.  a
+    //packet goes out when it holds framesPerPacket frames, or on the first
+    //check after its first frame has waited maxLatency seconds
+public:
+    FrameAggregator() :
+        framesPerPacket_(1),
+        maxLatency_(0),
+        frameLength_(0),
+        count_(0)
+    {
+    }
+
+    // a change of packet size first writes out what has been collected
+    template <class Stream>
+    void configure(size_t framesPerPacket, double maxLatency, Stream& stream){
+        framesPerPacket = std::max<size_t>(framesPerPacket, 1);
+        if (framesPerPacket != framesPerPacket_) {
+            flush(stream);
+            framesPerPacket_ = framesPerPacket;
+        }
+        maxLatency_ = maxLatency;
+    }
+
+    // where to put the next frame of frameLength elements.  the frame is
+    // only part of the packet once commit() is called
+    T* slot(BufferPool<T>& pool, size_t frameLength, const BULKIO::PrecisionUTCTime& time){
+        if (count_ == 0 || frameLength != frameLength_) {
+            // a different frame length can only follow an SRI update, which
+            // flushes first; start over regardless
+            count_ = 0;
+            frameLength_ = frameLength;
+            buffer_ = pool.allocate(frameLength*framesPerPacket_);
+            time_ = time;
+            since_ = boost::get_system_time();
+        }
+        return buffer_.data() + count_*frameLength_;
+    }
+
+    // add the frame written to the last slot; writes the packet when full
+    template <class Stream>
+    void commit(Stream& stream){
+        if (++count_ >= framesPerPacket_)
+            flush(stream);
+    }
+
+    // write out any frames collected.  unless forced, only once the first
+    // frame has waited maxLatency
+    template <class Stream>
+    void flush(Stream& stream, bool force=true){
+        if (count_ == 0)
+            return;
+        if (!force && boost::get_system_time() < since_ + boost::posix_time::microseconds(long(maxLatency_*1e6)))
+            return;
+        if (count_ < framesPerPacket_) {
+            stream.write(buffer_.slice(0, count_*frameLength_), time_);
+        } else {
+            stream.write(buffer_, time_);
+        }
+        count_ = 0;
+        buffer_ = redhawk::buffer<T>();
+    }
+
+    // drop any frames collected
+    void clear(){
+        count_ = 0;
+        buffer_ = redhawk::buffer<T>();
+    }
+
+private:
+    size_t framesPerPacket_;
+    double maxLatency_;
+    size_t frameLength_;
+    size_t count_;
+    redhawk::buffer<T> buffer_;
+    BULKIO::PrecisionUTCTime time_;
+    boost::system_time since_;
+};
+
+#endif
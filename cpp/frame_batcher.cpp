@@ -0,0 +1,161 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "frame_batcher.h"
+#include "psd_engine.h"
+
+#include <algorithm>
+#include <cstring>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/thread_time.hpp>
+
+FrameBatcher::FrameBatcher(size_t fftSize, bool complex, size_t maxBatch, double maxDelay) :
+    fftSz_(fftSize),
+    complex_(complex),
+    maxBatch_(std::max<size_t>(maxBatch, 1)),
+    maxDelay_(maxDelay),
+    bins_(complex ? fftSize : fftSize/2+1),
+    plan_(NULL),
+    dest_(maxBatch_, static_cast<std::complex<float>*>(NULL)),
+    queued_(0),
+    generation_(0)
+{
+    out_.resize(maxBatch_*bins_);
+    int n = fftSz_;
+    boost::mutex::scoped_lock lock(PsdEngine::planLock());
+    if (complex_) {
+        complexIn_.resize(maxBatch_*fftSz_);
+        plan_ = fftwf_plan_many_dft(1, &n, maxBatch_,
+                                    reinterpret_cast<fftwf_complex*>(&complexIn_[0]), NULL, 1, fftSz_,
+                                    reinterpret_cast<fftwf_complex*>(&out_[0]), NULL, 1, bins_,
+                                    FFTW_FORWARD, FFTW_MEASURE);
+    } else {
+        realIn_.resize(maxBatch_*fftSz_);
+        plan_ = fftwf_plan_many_dft_r2c(1, &n, maxBatch_,
+                                        &realIn_[0], NULL, 1, fftSz_,
+                                        reinterpret_cast<fftwf_complex*>(&out_[0]), NULL, 1, bins_,
+                                        FFTW_MEASURE);
+    }
+}
+
+FrameBatcher::~FrameBatcher(){
+    boost::mutex::scoped_lock lock(PsdEngine::planLock());
+    fftwf_destroy_plan(plan_);
+}
+
+void FrameBatcher::transform(const float* const* frames, const size_t* lengths, size_t count,
+                             std::complex<float>* out){
+    if (count == 0)
+        return;
+    boost::mutex::scoped_lock lock(lock_);
+    for (size_t i=0; i<count; i++)
+        add(frames[i], lengths[i], out+i*bins_);
+
+    // wait for the batch holding the last frame; earlier ones run first
+    if (queued_ == 0)
+        return;
+    unsigned long generation = generation_;
+    while (generation_ == generation) {
+        if (!done_.timed_wait(lock, deadline_) && generation_ == generation)
+            execute();
+    }
+}
+
+void FrameBatcher::add(const float* data, size_t length, std::complex<float>* out){
+    length = std::min(length, fftSz_);
+    if (queued_ == 0)
+        deadline_ = boost::get_system_time() + boost::posix_time::microseconds(long(maxDelay_*1e6));
+    if (complex_) {
+        const std::complex<float>* in = reinterpret_cast<const std::complex<float>*>(data);
+        std::complex<float>* slot = &complexIn_[queued_*fftSz_];
+        if (fftSz_ % 2 == 0) {
+            // fftshift by modulation, as in PsdEngine
+            for (size_t i=0; i<length; i++)
+                slot[i] = (i & 1) ? -in[i] : in[i];
+        } else {
+            memcpy(slot, in, length*sizeof(std::complex<float>));
+        }
+        std::fill(slot+length, slot+fftSz_, std::complex<float>(0,0));
+    } else {
+        float* slot = &realIn_[queued_*fftSz_];
+        memcpy(slot, data, length*sizeof(float));
+        std::fill(slot+length, slot+fftSz_, 0.0f);
+    }
+    dest_[queued_++] = out;
+    if (queued_ == maxBatch_)
+        execute();
+}
+
+void FrameBatcher::execute(){
+    // the plan always covers maxBatch frames; unused slots hold stale data
+    // whose results are simply not copied out
+    fftwf_execute(plan_);
+    for (size_t i=0; i<queued_; i++) {
+        std::complex<float>* spectrum = &out_[i*bins_];
+        if (complex_ && fftSz_ % 2 != 0)
+            std::rotate(spectrum, spectrum+(fftSz_+1)/2, spectrum+fftSz_);
+        memcpy(dest_[i], spectrum, bins_*sizeof(std::complex<float>));
+    }
+    queued_ = 0;
+    generation_++;
+    done_.notify_all();
+}
+
+FrameBatcherPool::FrameBatcherPool(size_t maxBatch, double maxDelay) :
+    maxBatch_(maxBatch),
+    maxDelay_(maxDelay),
+    state_(new State())
+{
+}
+
+boost::shared_ptr<FrameBatcher> FrameBatcherPool::get(size_t fftSize, bool complex){
+    if (maxBatch_ <= 1 || fftSize == 0 || fftSize > MAX_FFT_SIZE)
+        return boost::shared_ptr<FrameBatcher>();
+    Key key(fftSize, complex);
+    boost::mutex::scoped_lock lock(state_->lock);
+
+    // drop the batchers that no stream holds any more
+    for (std::map<Key, Entry>::iterator i = state_->batchers.begin(); i != state_->batchers.end();) {
+        if (i->first != key && i->second.claimed && i->second.batcher.use_count() == 1) {
+            state_->batchers.erase(i++);
+        } else {
+            ++i;
+        }
+    }
+
+    std::map<Key, Entry>::iterator entry = state_->batchers.find(key);
+    if (entry == state_->batchers.end()) {
+        state_->batchers.insert(std::make_pair(key, Entry()));
+        boost::thread(boost::bind(&FrameBatcherPool::build, state_, key, maxBatch_, maxDelay_)).detach();
+        return boost::shared_ptr<FrameBatcher>();
+    }
+    if (entry->second.building)
+        return boost::shared_ptr<FrameBatcher>();
+    entry->second.claimed = true;
+    return entry->second.batcher;
+}
+
+void FrameBatcherPool::build(boost::shared_ptr<State> state, Key key, size_t maxBatch, double maxDelay){
+    // planned without the pool lock, so other streams carry on meanwhile
+    boost::shared_ptr<FrameBatcher> batcher(new FrameBatcher(key.first, key.second, maxBatch, maxDelay));
+    boost::mutex::scoped_lock lock(state->lock);
+    Entry& entry = state->batchers[key];
+    entry.batcher = batcher;
+    entry.building = false;
+}
@@ -0,0 +1,125 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef FRAME_BATCHER_H
+#define FRAME_BATCHER_H
+
+#include <complex>
+#include <map>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <fftw3.h>
+#include "huge_pages.h"
+
+class FrameBatcher
+{
+    //gathers frames of one size and input type from many streams'
+    //processing threads into a single batched fft
+    //
+    //callers block in transform() until all of their frames have been
+    //transformed.  a batch runs as soon as it holds maxBatch frames, or once
+    //its first frame has waited maxDelay seconds, whichever comes first; the
+    //thread that fills the batch, or whose wait runs out, executes it for
+    //everyone.  the output matches PsdEngine (complex input centered on DC)
+public:
+    FrameBatcher(size_t fftSize, bool complex, size_t maxBatch, double maxDelay);
+    ~FrameBatcher();
+
+    size_t fftSize() const { return fftSz_; }
+    bool complex() const { return complex_; }
+    size_t outputLength() const { return bins_; }
+
+    // frames[i] holds lengths[i] samples (zero padded to fftSize); its
+    // spectrum is written to out + i*outputLength()
+    void transform(const float* const* frames, const size_t* lengths, size_t count,
+                   std::complex<float>* out);
+
+private:
+    FrameBatcher(const FrameBatcher&);
+    FrameBatcher& operator=(const FrameBatcher&);
+
+    // called with lock_ held
+    void add(const float* data, size_t length, std::complex<float>* out);
+    void execute();
+
+    size_t fftSz_;
+    bool complex_;
+    size_t maxBatch_;
+    double maxDelay_;
+    size_t bins_;
+
+    fftwf_plan plan_;
+    RealHugeVector realIn_;
+    ComplexHugeVector complexIn_;
+    ComplexHugeVector out_;
+
+    boost::mutex lock_;
+    boost::condition_variable done_;
+    // destination of each queued frame
+    std::vector<std::complex<float>*> dest_;
+    size_t queued_;
+    // number of batches executed so far
+    unsigned long generation_;
+    boost::system_time deadline_;
+};
+
+class FrameBatcherPool
+{
+    //the batchers shared by all of the component's streams, one for each
+    //fft size and input type in use
+    //
+    //a batcher is planned on a helper thread, like PsdEngineBuilder, so the
+    //stream that first asks for it (and every other stream) keeps
+    //transforming its own frames until it is ready.  callers hold on to the
+    //batcher they were given; one that no caller holds any more is dropped
+public:
+    FrameBatcherPool(size_t maxBatch, double maxDelay);
+
+    // batching only pays off for small transforms; larger ones already
+    // keep the vector units busy
+    static const size_t MAX_FFT_SIZE = 4096;
+
+    // the batcher for this transform, or NULL if it isn't batched or is
+    // still being planned
+    boost::shared_ptr<FrameBatcher> get(size_t fftSize, bool complex);
+
+private:
+    typedef std::pair<size_t, bool> Key;
+    struct Entry {
+        Entry() : building(true), claimed(false) {}
+        boost::shared_ptr<FrameBatcher> batcher;
+        bool building;
+        // handed out at least once since it was planned
+        bool claimed;
+    };
+    // outlives the pool while a build is in progress
+    struct State {
+        boost::mutex lock;
+        std::map<Key, Entry> batchers;
+    };
+    static void build(boost::shared_ptr<State> state, Key key, size_t maxBatch, double maxDelay);
+
+    size_t maxBatch_;
+    double maxDelay_;
+    boost::shared_ptr<State> state_;
+};
+
+#endif
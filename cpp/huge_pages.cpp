@@ -0,0 +1,230 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "huge_pages.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <sys/mman.h>
+#include <boost/thread/mutex.hpp>
+
+#include <fftw3.h>
+
+namespace {
+
+    enum Backing {
+        BACKING_STANDARD,
+        BACKING_TRANSPARENT,
+        BACKING_EXPLICIT
+    };
+
+    // how the memory has to be returned
+    enum Source {
+        SOURCE_FFTW,
+        SOURCE_MEMALIGN,
+        SOURCE_MMAP
+    };
+
+    struct Allocation {
+        Backing backing;
+        Source source;
+        size_t bytes;       // requested size
+        size_t mapped;      // length of the mapping, for explicit pages
+    };
+
+    // large allocations, by address, so deallocate() knows how to free them
+    // and backing() can report them.  allocations are rare (buffers are
+    // resized on configuration changes only), so a locked map is plenty
+    struct Registry {
+        Registry() : mode(hugepages::MODE_OFF) {}
+        boost::mutex lock;
+        hugepages::Mode mode;
+        std::map<void*, Allocation> allocations;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    size_t readHugePageSize() {
+        std::ifstream meminfo("/proc/meminfo");
+        std::string line;
+        while (std::getline(meminfo, line)) {
+            unsigned long kb;
+            if (sscanf(line.c_str(), "Hugepagesize: %lu kB", &kb) == 1 && kb > 0)
+                return kb*1024;
+        }
+        return 2*1024*1024;
+    }
+
+    // THP can be disabled system-wide, in which case madvise still succeeds
+    bool transparentAvailable() {
+        std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string setting;
+        if (!std::getline(enabled, setting))
+            return false;
+        return setting.find("[never]") == std::string::npos;
+    }
+
+    size_t roundUp(size_t bytes, size_t page) {
+        return (bytes + page - 1) / page * page;
+    }
+
+    void* allocateExplicit(size_t bytes, Allocation& allocation) {
+#ifdef MAP_HUGETLB
+        allocation.mapped = roundUp(bytes, hugepages::threshold());
+        void* data = mmap(NULL, allocation.mapped, PROT_READ|PROT_WRITE,
+                          MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED) {
+            allocation.backing = BACKING_EXPLICIT;
+            allocation.source = SOURCE_MMAP;
+            return data;
+        }
+#endif
+        return NULL;
+    }
+
+    void* allocateTransparent(size_t bytes, Allocation& allocation) {
+        static const bool available = transparentAvailable();
+        size_t page = hugepages::threshold();
+        void* data = NULL;
+        if (posix_memalign(&data, page, roundUp(bytes, page)) != 0)
+            return NULL;
+        allocation.backing = BACKING_STANDARD;
+        allocation.source = SOURCE_MEMALIGN;
+#ifdef MADV_HUGEPAGE
+        if (available && madvise(data, roundUp(bytes, page), MADV_HUGEPAGE) == 0)
+            allocation.backing = BACKING_TRANSPARENT;
+#endif
+        return data;
+    }
+
+    const char* backingName(Backing backing) {
+        switch (backing) {
+            case BACKING_EXPLICIT:    return "explicit";
+            case BACKING_TRANSPARENT: return "transparent";
+            default:                  return "standard";
+        }
+    }
+}
+
+namespace hugepages {
+
+    void setMode(Mode mode) {
+        boost::mutex::scoped_lock lock(registry().lock);
+        registry().mode = mode;
+    }
+
+    Mode mode() {
+        boost::mutex::scoped_lock lock(registry().lock);
+        return registry().mode;
+    }
+
+    bool parseMode(const std::string& text, Mode& mode) {
+        if (text == "off")
+            mode = MODE_OFF;
+        else if (text == "transparent")
+            mode = MODE_TRANSPARENT;
+        else if (text == "explicit")
+            mode = MODE_EXPLICIT;
+        else
+            return false;
+        return true;
+    }
+
+    size_t threshold() {
+        static const size_t size = readHugePageSize();
+        return size;
+    }
+
+    void* allocate(size_t bytes) {
+        Mode current = mode();
+        if (bytes < threshold()) {
+            void* data = fftwf_malloc(bytes);
+            if (!data)
+                throw std::bad_alloc();
+            return data;
+        }
+
+        Allocation allocation;
+        allocation.backing = BACKING_STANDARD;
+        allocation.source = SOURCE_FFTW;
+        allocation.bytes = bytes;
+        allocation.mapped = 0;
+        void* data = NULL;
+        if (current == MODE_EXPLICIT)
+            data = allocateExplicit(bytes, allocation);
+        if (!data && current != MODE_OFF)
+            data = allocateTransparent(bytes, allocation);
+        if (!data)
+            data = fftwf_malloc(bytes);
+        if (!data)
+            throw std::bad_alloc();
+
+        boost::mutex::scoped_lock lock(registry().lock);
+        registry().allocations[data] = allocation;
+        return data;
+    }
+
+    void deallocate(void* data) {
+        if (!data)
+            return;
+        Allocation allocation;
+        {
+            boost::mutex::scoped_lock lock(registry().lock);
+            std::map<void*, Allocation>::iterator found = registry().allocations.find(data);
+            if (found == registry().allocations.end()) {
+                fftwf_free(data);
+                return;
+            }
+            allocation = found->second;
+            registry().allocations.erase(found);
+        }
+        switch (allocation.source) {
+            case SOURCE_MMAP:     munmap(data, allocation.mapped); break;
+            case SOURCE_MEMALIGN: free(data); break;
+            default:              fftwf_free(data); break;
+        }
+    }
+
+    std::string backing() {
+        size_t totals[3] = { 0, 0, 0 };
+        {
+            boost::mutex::scoped_lock lock(registry().lock);
+            std::map<void*, Allocation>::const_iterator i;
+            for (i = registry().allocations.begin(); i != registry().allocations.end(); ++i)
+                totals[i->second.backing] += i->second.bytes;
+        }
+        std::ostringstream result;
+        const Backing order[3] = { BACKING_EXPLICIT, BACKING_TRANSPARENT, BACKING_STANDARD };
+        for (int i=0; i<3; i++) {
+            if (totals[order[i]] == 0)
+                continue;
+            if (result.tellp() > 0)
+                result << ", ";
+            result << backingName(order[i]) << " " << (totals[order[i]] + (1<<20) - 1)/(1<<20) << " MiB";
+        }
+        return result.tellp() > 0 ? result.str() : std::string("none");
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <complex>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace hugepages {
+
+    // backing for large processing buffers
+    //   MODE_OFF:         plain fftw-aligned heap memory
+    //   MODE_TRANSPARENT: huge-page aligned memory advised for transparent
+    //                     huge pages (MADV_HUGEPAGE)
+    //   MODE_EXPLICIT:    MAP_HUGETLB mappings from the reserved huge page
+    //                     pool, falling back to transparent huge pages when
+    //                     the pool is empty or not configured
+    enum Mode {
+        MODE_OFF,
+        MODE_TRANSPARENT,
+        MODE_EXPLICIT
+    };
+
+    // process-wide; affects allocations made after the call
+    void setMode(Mode mode);
+    Mode mode();
+
+    // parse "off", "transparent" or "explicit"; returns false if unknown
+    bool parseMode(const std::string& text, Mode& mode);
+
+    // buffers smaller than this always use the heap; one huge page
+    size_t threshold();
+
+    // fftw-aligned allocation of the given size in bytes, backed according
+    // to the current mode.  never returns NULL; throws std::bad_alloc
+    void* allocate(size_t bytes);
+    void deallocate(void* data);
+
+    // the backings of the large buffers currently allocated with their
+    // total sizes, e.g. "explicit 48 MiB, standard 4 MiB", or "none"
+    std::string backing();
+}
+
+template <typename T>
+class HugePageAllocator
+{
+    //std allocator for processing vectors that are large enough to benefit
+    //from huge pages; see hugepages::allocate
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind { typedef HugePageAllocator<U> other; };
+
+    HugePageAllocator() {}
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>&) {}
+
+    pointer allocate(size_type n, const void* = 0) {
+        return static_cast<pointer>(hugepages::allocate(n*sizeof(T)));
+    }
+    void deallocate(pointer p, size_type) { hugepages::deallocate(p); }
+
+    size_type max_size() const { return size_type(-1)/sizeof(T); }
+    void construct(pointer p, const T& value) { new(p) T(value); }
+    void destroy(pointer p) { p->~T(); }
+
+    pointer address(reference x) const { return &x; }
+    const_pointer address(const_reference x) const { return &x; }
+
+    template <typename U>
+    bool operator==(const HugePageAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const HugePageAllocator<U>&) const { return false; }
+};
+
+// processing vectors; fftw-aligned so the FFTW plans can use SIMD
+typedef std::vector<float, HugePageAllocator<float> > RealHugeVector;
+typedef std::vector<std::complex<float>, HugePageAllocator<std::complex<float> > > ComplexHugeVector;
+
+#endif
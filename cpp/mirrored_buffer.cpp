@@ -0,0 +1,138 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "mirrored_buffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    // an unnamed file to back both mappings
+    int createBackingFile(){
+#ifdef SYS_memfd_create
+        int fd = syscall(SYS_memfd_create, "psd-ring", 0);
+        if (fd >= 0)
+            return fd;
+#endif
+        char path[] = "/dev/shm/psd-ring-XXXXXX";
+        int fd2 = mkstemp(path);
+        if (fd2 < 0)
+            return -1;
+        unlink(path);
+        return fd2;
+    }
+}
+
+MirroredBuffer::MirroredBuffer() :
+    data_(NULL),
+    size_(0),
+    mirrored_(false)
+{
+}
+
+MirroredBuffer::MirroredBuffer(const MirroredBuffer& other) :
+    data_(NULL),
+    size_(0),
+    mirrored_(false)
+{
+    if (other.size_) {
+        allocate(other.size_);
+        std::memcpy(data_, other.data_, size_);
+    }
+}
+
+MirroredBuffer& MirroredBuffer::operator=(const MirroredBuffer& other){
+    MirroredBuffer copy(other);
+    swap(copy);
+    return *this;
+}
+
+MirroredBuffer::~MirroredBuffer(){
+    clear();
+}
+
+void MirroredBuffer::clear(){
+    if (data_) {
+        if (mirrored_)
+            munmap(data_, 2*size_);
+        else
+            free(data_);
+    }
+    data_ = NULL;
+    size_ = 0;
+    mirrored_ = false;
+}
+
+void MirroredBuffer::swap(MirroredBuffer& other){
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(mirrored_, other.mirrored_);
+}
+
+void MirroredBuffer::allocate(size_t bytes){
+    clear();
+    size_t page = sysconf(_SC_PAGESIZE);
+    bytes = std::max<size_t>((bytes + page - 1) / page * page, page);
+    if (map(bytes))
+        return;
+
+    // no mirror; plain memory, aligned for simd loads
+    void* data = NULL;
+    if (posix_memalign(&data, 64, bytes) != 0)
+        throw std::bad_alloc();
+    data_ = static_cast<char*>(data);
+    size_ = bytes;
+    mirrored_ = false;
+}
+
+bool MirroredBuffer::map(size_t bytes){
+    int fd = createBackingFile();
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, bytes) != 0) {
+        close(fd);
+        return false;
+    }
+
+    // reserve twice the size, then map the file over each half
+    void* base = mmap(NULL, 2*bytes, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    char* first = static_cast<char*>(base);
+    bool mapped =
+        mmap(first, bytes, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) == first &&
+        mmap(first+bytes, bytes, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) == first+bytes;
+    // the mappings keep the file alive
+    close(fd);
+    if (!mapped) {
+        munmap(base, 2*bytes);
+        return false;
+    }
+    data_ = first;
+    size_ = bytes;
+    mirrored_ = true;
+    return true;
+}
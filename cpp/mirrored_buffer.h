@@ -0,0 +1,58 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef MIRRORED_BUFFER_H
+#define MIRRORED_BUFFER_H
+
+#include <cstddef>
+
+class MirroredBuffer
+{
+    //memory mapped twice, back to back, so that a region wrapping around
+    //the end of the buffer can be read and written as one contiguous block
+    //(data()[size()+i] is data()[i])
+    //
+    //if the double mapping can't be set up, plain memory is used instead
+    //and mirrored() is false; the caller then has to keep its regions from
+    //wrapping
+public:
+    MirroredBuffer();
+    // copies the contents into a new mapping
+    MirroredBuffer(const MirroredBuffer& other);
+    MirroredBuffer& operator=(const MirroredBuffer& other);
+    ~MirroredBuffer();
+
+    // at least bytes, rounded up to whole pages; the contents are lost
+    void allocate(size_t bytes);
+    void clear();
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool mirrored() const { return mirrored_; }
+
+    void swap(MirroredBuffer& other);
+
+private:
+    bool map(size_t bytes);
+
+    char* data_;
+    size_t size_;
+    bool mirrored_;
+};
+
+#endif
@@ -0,0 +1,350 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "multitaper.h"
+#include "psd_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <boost/thread/mutex.hpp>
+
+namespace {
+    // iterations of the adaptive weighting, and the relative change in
+    // every bin below which it stops early
+    const size_t MAX_WEIGHT_ITERATIONS = 20;
+    const float WEIGHT_TOLERANCE = 1e-4f;
+
+    // number of eigenvalues of the symmetric tridiagonal matrix
+    // (diag, off) that are less than x (Sturm sequence count)
+    size_t eigenvaluesBelow(const std::vector<double>& diag, const std::vector<double>& off, double x){
+        size_t count = 0;
+        double q = 1.0;
+        for (size_t i=0; i<diag.size(); i++) {
+            double e2 = (i > 0) ? off[i-1]*off[i-1] : 0.0;
+            q = diag[i] - x - e2/q;
+            if (q == 0.0)
+                q = -1e-300;
+            if (q < 0)
+                count++;
+        }
+        return count;
+    }
+
+    // solve (T - shift*I) y = x in place with the Thomas algorithm; zero
+    // pivots are nudged, since T - shift*I is nearly singular by design
+    void solveShifted(const std::vector<double>& diag, const std::vector<double>& off, double shift,
+                      std::vector<double>& x, std::vector<double>& scratch){
+        size_t n = diag.size();
+        scratch.resize(n);
+        double pivot = diag[0] - shift;
+        for (size_t i=0; i<n; i++) {
+            if (i > 0) {
+                double factor = off[i-1]/pivot;
+                pivot = diag[i] - shift - factor*off[i-1];
+                x[i] -= factor*x[i-1];
+            }
+            if (std::fabs(pivot) < 1e-300)
+                pivot = 1e-300;
+            scratch[i] = pivot;
+        }
+        x[n-1] /= scratch[n-1];
+        for (size_t i=n-1; i-- > 0;)
+            x[i] = (x[i] - off[i]*x[i+1]) / scratch[i];
+    }
+
+    typedef std::map<std::pair<std::pair<size_t, size_t>, double>, boost::shared_ptr<DpssTapers> > TaperCache;
+}
+
+boost::shared_ptr<const DpssTapers> DpssTapers::get(size_t length, size_t count, double bandwidth){
+    static boost::mutex lock;
+    static TaperCache cache;
+    boost::mutex::scoped_lock guard(lock);
+
+    boost::shared_ptr<DpssTapers>& tapers = cache[std::make_pair(std::make_pair(length, count), bandwidth)];
+    if (!tapers) {
+        // drop configurations that are no longer in use before adding one
+        for (TaperCache::iterator i=cache.begin(); i!=cache.end();) {
+            if (i->second && i->second.unique())
+                cache.erase(i++);
+            else
+                ++i;
+        }
+        tapers.reset(new DpssTapers());
+        tapers->length = length;
+        tapers->count = count;
+        tapers->bandwidth = bandwidth;
+        tapers->compute();
+    }
+    return tapers;
+}
+
+void DpssTapers::compute(){
+    // the tapers are the eigenvectors of the tridiagonal matrix that
+    // commutes with the time- and band-limiting operator (Slepian), with
+    // the largest eigenvalues giving the most concentrated tapers
+    const size_t n = length;
+    const double w = bandwidth/n;
+    std::vector<double> diag(n), off(n > 1 ? n-1 : 0);
+    for (size_t i=0; i<n; i++) {
+        double center = (double(n)-1-2.0*i)/2;
+        diag[i] = center*center*cos(2*M_PI*w);
+        if (i+1 < n)
+            off[i] = (i+1)*double(n-1-i)/2;
+    }
+    double lower = diag[0], upper = diag[0];
+    for (size_t i=0; i<n; i++) {
+        double radius = (i > 0 ? off[i-1] : 0.0) + (i+1 < n ? off[i] : 0.0);
+        lower = std::min(lower, diag[i]-radius);
+        upper = std::max(upper, diag[i]+radius);
+    }
+
+    count = std::min(count, n);
+    tapers.resize(count*n);
+    concentration.resize(count);
+    std::vector<double> taper(n), scratch;
+    for (size_t k=0; k<count; k++) {
+        // bisect for the (k+1)-th largest eigenvalue
+        size_t rank = n-1-k;
+        double lo = lower, hi = upper;
+        for (size_t iteration=0; iteration<200 && hi-lo > 1e-15*std::max(std::fabs(lo), std::fabs(hi)); iteration++) {
+            double mid = 0.5*(lo+hi);
+            if (eigenvaluesBelow(diag, off, mid) > rank)
+                hi = mid;
+            else
+                lo = mid;
+        }
+        double eigenvalue = 0.5*(lo+hi);
+
+        // inverse iteration from an arbitrary (asymmetric) start
+        for (size_t i=0; i<n; i++)
+            taper[i] = 1.0 + 0.5*sin(0.7*i + k);
+        for (size_t iteration=0; iteration<3; iteration++) {
+            solveShifted(diag, off, eigenvalue, taper, scratch);
+            double energy = 0;
+            for (size_t i=0; i<n; i++)
+                energy += taper[i]*taper[i];
+            double scale = 1.0/sqrt(energy);
+            for (size_t i=0; i<n; i++)
+                taper[i] *= scale;
+        }
+
+        // symmetric tapers have a positive mean, antisymmetric ones start
+        // positive
+        double sign = 0;
+        for (size_t i=0; i<n; i++)
+            sign += taper[i] * ((k % 2 == 0) ? 1.0 : (double(n)-1-2.0*i));
+        double scale = (sign < 0 ? -1.0 : 1.0) * sqrt(double(n));
+        for (size_t i=0; i<n; i++)
+            tapers[k*n+i] = float(taper[i]*scale);
+
+        // concentration from the taper's autocorrelation r:
+        // sum over lags of r(m) sin(2 pi w m)/(pi m)
+        size_t padded = 2*n;
+        RealHugeVector real(padded, 0.0f);
+        ComplexHugeVector spectrum(padded/2+1);
+        fftwf_plan forward, inverse;
+        {
+            boost::mutex::scoped_lock lock(PsdEngine::planLock());
+            forward = fftwf_plan_dft_r2c_1d(padded, &real[0], reinterpret_cast<fftwf_complex*>(&spectrum[0]), FFTW_ESTIMATE);
+            inverse = fftwf_plan_dft_c2r_1d(padded, reinterpret_cast<fftwf_complex*>(&spectrum[0]), &real[0], FFTW_ESTIMATE);
+        }
+        for (size_t i=0; i<n; i++)
+            real[i] = float(taper[i]);
+        fftwf_execute(forward);
+        for (size_t i=0; i<spectrum.size(); i++)
+            spectrum[i] = std::norm(spectrum[i]);
+        fftwf_execute(inverse);
+        double ratio = 2*w*real[0]/padded;
+        for (size_t m=1; m<n; m++)
+            ratio += 2*(real[m]/padded)*sin(2*M_PI*w*m)/(M_PI*m);
+        concentration[k] = std::min(std::max(ratio, 0.0), 1.0);
+        {
+            boost::mutex::scoped_lock lock(PsdEngine::planLock());
+            fftwf_destroy_plan(forward);
+            fftwf_destroy_plan(inverse);
+        }
+    }
+}
+
+Multitaper::Multitaper() :
+    fftSz_(0),
+    complex_(false),
+    bins_(0),
+    plan_(NULL)
+{
+}
+
+Multitaper::~Multitaper(){
+    release();
+}
+
+void Multitaper::release(){
+    if (plan_) {
+        boost::mutex::scoped_lock lock(PsdEngine::planLock());
+        fftwf_destroy_plan(plan_);
+        plan_ = NULL;
+    }
+    tapers_.reset();
+    RealHugeVector().swap(realIn_);
+    ComplexHugeVector().swap(complexIn_);
+    ComplexHugeVector().swap(out_);
+    RealHugeVector().swap(eigen_);
+    RealHugeVector().swap(weightSum_);
+    RealHugeVector().swap(weighted_);
+    fftSz_ = 0;
+    bins_ = 0;
+}
+
+bool Multitaper::matches(size_t fftSize, size_t tapers, double bandwidth, bool complex) const{
+    return plan_ && fftSize == fftSz_ && complex == complex_ &&
+        tapers_->count == std::min(tapers, fftSize) && tapers_->bandwidth == bandwidth;
+}
+
+void Multitaper::configure(size_t fftSize, size_t tapers, double bandwidth, bool complex){
+    if (matches(fftSize, tapers, bandwidth, complex))
+        return;
+    release();
+    fftSz_ = fftSize;
+    complex_ = complex;
+    bins_ = complex ? fftSize : fftSize/2+1;
+    tapers_ = DpssTapers::get(fftSize, tapers, bandwidth);
+
+    size_t count = tapers_->count;
+    out_.resize(count*bins_);
+    eigen_.resize(count*bins_);
+    weightSum_.resize(bins_);
+    weighted_.resize(bins_);
+
+    // one plan transforms every tapered copy of the frame
+    int n = fftSz_;
+    boost::mutex::scoped_lock lock(PsdEngine::planLock());
+    if (complex_) {
+        complexIn_.resize(count*fftSz_);
+        plan_ = fftwf_plan_many_dft(1, &n, count,
+                                    reinterpret_cast<fftwf_complex*>(&complexIn_[0]), NULL, 1, fftSz_,
+                                    reinterpret_cast<fftwf_complex*>(&out_[0]), NULL, 1, bins_,
+                                    FFTW_FORWARD, FFTW_MEASURE);
+    } else {
+        realIn_.resize(count*fftSz_);
+        plan_ = fftwf_plan_many_dft_r2c(1, &n, count,
+                                        &realIn_[0], NULL, 1, fftSz_,
+                                        reinterpret_cast<fftwf_complex*>(&out_[0]), NULL, 1, bins_,
+                                        FFTW_MEASURE);
+    }
+}
+
+void Multitaper::transform(const float* data, size_t length, std::complex<float>* spectrum, float* power){
+    length = std::min(length, fftSz_);
+    size_t count = tapers_->count;
+    const float* tapers = &tapers_->tapers[0];
+
+    // the frame's energy is the white noise level of a bin (the tapers
+    // are scaled to preserve it)
+    float variance = 0;
+    if (complex_) {
+        const std::complex<float>* in = reinterpret_cast<const std::complex<float>*>(data);
+        for (size_t i=0; i<length; i++)
+            variance += std::norm(in[i]);
+        for (size_t k=0; k<count; k++) {
+            const float* taper = tapers + k*fftSz_;
+            std::complex<float>* slot = &complexIn_[k*fftSz_];
+            if (fftSz_ % 2 == 0) {
+                // fftshift by modulation, as in PsdEngine
+                for (size_t i=0; i<length; i++)
+                    slot[i] = in[i] * ((i & 1) ? -taper[i] : taper[i]);
+            } else {
+                for (size_t i=0; i<length; i++)
+                    slot[i] = in[i] * taper[i];
+            }
+            std::fill(slot+length, slot+fftSz_, std::complex<float>(0,0));
+        }
+    } else {
+        for (size_t i=0; i<length; i++)
+            variance += data[i]*data[i];
+        for (size_t k=0; k<count; k++) {
+            const float* taper = tapers + k*fftSz_;
+            float* slot = &realIn_[k*fftSz_];
+            for (size_t i=0; i<length; i++)
+                slot[i] = data[i] * taper[i];
+            std::fill(slot+length, slot+fftSz_, 0.0f);
+        }
+    }
+    fftwf_execute(plan_);
+
+    for (size_t k=0; k<count; k++) {
+        std::complex<float>* out = &out_[k*bins_];
+        if (complex_ && fftSz_ % 2 != 0)
+            std::rotate(out, out+(fftSz_+1)/2, out+fftSz_);
+        float* eigen = &eigen_[k*bins_];
+        for (size_t i=0; i<bins_; i++)
+            eigen[i] = std::norm(out[i]);
+    }
+    memcpy(spectrum, &out_[0], bins_*sizeof(std::complex<float>));
+
+    if (count == 1) {
+        memcpy(power, &eigen_[0], bins_*sizeof(float));
+        return;
+    }
+    adaptiveWeights(power, variance);
+}
+
+void Multitaper::adaptiveWeights(float* power, float variance){
+    // Thomson's adaptive weighting (Percival and Walden, eq. 370a/b):
+    //   d_k = sqrt(l_k) S / (l_k S + (1-l_k) variance)
+    //   S = sum(d_k^2 S_k) / sum(d_k^2)
+    // iterated from the average of the first two eigenspectra.  each pass
+    // runs across all bins for one taper at a time
+    size_t count = tapers_->count;
+    const std::vector<double>& concentration = tapers_->concentration;
+    const float* first = &eigen_[0];
+    const float* second = &eigen_[bins_];
+    for (size_t i=0; i<bins_; i++)
+        power[i] = 0.5f*(first[i] + second[i]);
+
+    float* weighted = &weighted_[0];
+    float* weightSum = &weightSum_[0];
+    for (size_t iteration=0; iteration<MAX_WEIGHT_ITERATIONS; iteration++) {
+        std::fill(weighted_.begin(), weighted_.end(), 0.0f);
+        std::fill(weightSum_.begin(), weightSum_.end(), 0.0f);
+        for (size_t k=0; k<count; k++) {
+            const float lambda = float(concentration[k]);
+            const float root = sqrtf(lambda);
+            const float leakage = (1.0f-lambda)*variance;
+            const float* eigen = &eigen_[k*bins_];
+            for (size_t i=0; i<bins_; i++) {
+                float denominator = lambda*power[i] + leakage;
+                float d = (denominator > 0) ? root*power[i]/denominator : 1.0f;
+                float weight = d*d;
+                weighted[i] += weight*eigen[i];
+                weightSum[i] += weight;
+            }
+        }
+
+        float change = 0;
+        for (size_t i=0; i<bins_; i++) {
+            float estimate = (weightSum[i] > 0) ? weighted[i]/weightSum[i] : power[i];
+            float delta = std::fabs(estimate-power[i]);
+            change = std::max(change, (power[i] > 0) ? delta/power[i] : delta);
+            power[i] = estimate;
+        }
+        if (change < WEIGHT_TOLERANCE)
+            break;
+    }
+}
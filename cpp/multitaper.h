@@ -0,0 +1,97 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef MULTITAPER_H
+#define MULTITAPER_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <fftw3.h>
+#include "huge_pages.h"
+
+struct DpssTapers
+{
+    //the first count discrete prolate spheroidal sequences of a length and
+    //time-bandwidth product, most concentrated first
+    //
+    //computing them is expensive for large lengths, so they are built once
+    //per configuration and shared through get()
+    static boost::shared_ptr<const DpssTapers> get(size_t length, size_t count, double bandwidth);
+
+    size_t length;
+    size_t count;
+    double bandwidth;
+    // count tapers of length samples, each scaled to a total energy of
+    // length so that white noise has the same level as with no taper
+    std::vector<float> tapers;
+    // fraction of each taper's energy inside [-W, W], W = bandwidth/length
+    std::vector<double> concentration;
+
+private:
+    void compute();
+};
+
+class Multitaper
+{
+    //Thomson multitaper psd of one frame: the frame is multiplied by each
+    //DPSS taper, all of the tapered copies go through one batched fft, and
+    //the eigenspectra are combined with Thomson's adaptive weights
+    //
+    //output bins are laid out like PsdEngine's (complex input centered
+    //on DC)
+public:
+    Multitaper();
+    ~Multitaper();
+
+    // builds the tapers and the batched transform
+    void configure(size_t fftSize, size_t tapers, double bandwidth, bool complex);
+    void release();
+
+    bool matches(size_t fftSize, size_t tapers, double bandwidth, bool complex) const;
+    size_t outputLength() const { return bins_; }
+
+    // length samples (zero padded to fftSize).  spectrum receives the fft
+    // of the first, most concentrated, taper and power the multitaper
+    // estimate
+    void transform(const float* data, size_t length, std::complex<float>* spectrum, float* power);
+
+private:
+    Multitaper(const Multitaper&);
+    Multitaper& operator=(const Multitaper&);
+
+    void adaptiveWeights(float* power, float variance);
+
+    size_t fftSz_;
+    bool complex_;
+    size_t bins_;
+    boost::shared_ptr<const DpssTapers> tapers_;
+
+    fftwf_plan plan_;
+    RealHugeVector realIn_;
+    ComplexHugeVector complexIn_;
+    ComplexHugeVector out_;
+    // |fft|^2 of each taper, one array after another
+    RealHugeVector eigen_;
+    RealHugeVector weightSum_;
+    RealHugeVector weighted_;
+};
+
+#endif
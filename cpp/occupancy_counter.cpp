@@ -0,0 +1,73 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "occupancy_counter.h"
+
+#include <algorithm>
+
+namespace {
+    inline float binPower(const std::complex<float>& value){ return std::norm(value); }
+    inline float binPower(float power){ return power; }
+}
+
+OccupancyCounter::OccupancyCounter() :
+    threshold_(0),
+    frames_(0)
+{
+}
+
+void OccupancyCounter::configure(size_t bins, float threshold){
+    threshold_ = threshold;
+    counts_.resize(bins);
+    reset();
+}
+
+void OccupancyCounter::reset(){
+    std::fill(counts_.begin(), counts_.end(), 0);
+    frames_ = 0;
+}
+
+void OccupancyCounter::release(){
+    std::vector<uint32_t>().swap(counts_);
+    frames_ = 0;
+}
+
+void OccupancyCounter::add(const std::complex<float>* fft){
+    count(fft);
+}
+
+void OccupancyCounter::add(const float* power){
+    count(power);
+}
+
+template <class T>
+void OccupancyCounter::count(const T* frame){
+    // compare and add the mask; no branches, so the loop vectorizes
+    const float threshold = threshold_;
+    uint32_t* counts = &counts_[0];
+    const size_t bins = counts_.size();
+    for (size_t i=0; i<bins; i++)
+        counts[i] += (binPower(frame[i]) > threshold) ? 1 : 0;
+    frames_++;
+}
+
+void OccupancyCounter::result(float* fraction) const{
+    const float scale = frames_ ? 1.0f/frames_ : 0.0f;
+    for (size_t i=0; i<counts_.size(); i++)
+        fraction[i] = counts_[i]*scale;
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef OCCUPANCY_COUNTER_H
+#define OCCUPANCY_COUNTER_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+class OccupancyCounter
+{
+    //per-bin count of the frames whose power is above a threshold, for
+    //spectrum occupancy over long intervals.  only the counts are kept, so
+    //memory is one counter per bin however many frames are counted
+public:
+    OccupancyCounter();
+
+    // threshold is in linear power; drops any counts
+    void configure(size_t bins, float threshold);
+    void reset();
+    void release();
+
+    // count the bins of one frame above the threshold, from its spectrum
+    // or from its power
+    void add(const std::complex<float>* fft);
+    void add(const float* power);
+
+    size_t bins() const { return counts_.size(); }
+    size_t frames() const { return frames_; }
+    float threshold() const { return threshold_; }
+
+    // fraction of the frames counted that were above the threshold
+    void result(float* fraction) const;
+
+private:
+    template <class T>
+    void count(const T* frame);
+
+    float threshold_;
+    size_t frames_;
+    std::vector<uint32_t> counts_;
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "peak_finder.h"
+
+#include <algorithm>
+
+namespace {
+    struct Stronger {
+        Stronger(const float* psd) : psd_(psd) {}
+        bool operator()(uint32_t a, uint32_t b) const {
+            return psd_[a] > psd_[b] || (psd_[a] == psd_[b] && a < b);
+        }
+        const float* psd_;
+    };
+}
+
+const std::vector<PeakFinder::Peak>& PeakFinder::find(const float* psd, size_t bins, size_t count, bool interpolate){
+    peaks_.clear();
+    if (bins == 0 || count == 0)
+        return peaks_;
+
+    // mark the local maxima; the edges only have one neighbor
+    mask_.resize(bins);
+    uint8_t* mask = &mask_[0];
+    if (bins == 1) {
+        mask[0] = 1;
+    } else {
+        mask[0] = psd[0] >= psd[1];
+        for (size_t i=1; i<bins-1; i++)
+            mask[i] = (psd[i] > psd[i-1]) & (psd[i] >= psd[i+1]);
+        mask[bins-1] = psd[bins-1] > psd[bins-2];
+    }
+
+    candidates_.clear();
+    for (size_t i=0; i<bins; i++) {
+        if (mask[i])
+            candidates_.push_back(i);
+    }
+
+    // rank only as many as are needed
+    size_t found = std::min(count, candidates_.size());
+    std::partial_sort(candidates_.begin(), candidates_.begin()+found, candidates_.end(), Stronger(psd));
+
+    peaks_.resize(found);
+    for (size_t i=0; i<found; i++) {
+        size_t k = candidates_[i];
+        Peak& peak = peaks_[i];
+        peak.bin = k;
+        peak.power = psd[k];
+        if (!interpolate || k == 0 || k+1 >= bins)
+            continue;
+        // vertex of the parabola through (k-1, a), (k, b), (k+1, c)
+        float a = psd[k-1];
+        float b = psd[k];
+        float c = psd[k+1];
+        float curvature = a - 2*b + c;
+        if (curvature >= 0)
+            continue;
+        float offset = 0.5f*(a-c)/curvature;
+        peak.bin = k + offset;
+        peak.power = b - 0.25f*(a-c)*offset;
+    }
+    return peaks_;
+}
@@ -0,0 +1,53 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef PEAK_FINDER_H
+#define PEAK_FINDER_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+class PeakFinder
+{
+    //the strongest local maxima of a psd frame
+    //
+    //a bin is a peak if it is above its lower neighbor and not below its
+    //upper one.  the bins are first marked with a compare across the whole
+    //frame, then only the marked bins are ranked
+public:
+    struct Peak {
+        // bin position, fractional when interpolated
+        double bin;
+        float power;
+    };
+
+    // find up to count peaks, strongest first.  with interpolate, the
+    // position and power come from a parabola through each peak and its
+    // two neighbors
+    const std::vector<Peak>& find(const float* psd, size_t bins, size_t count, bool interpolate);
+
+    const std::vector<Peak>& peaks() const { return peaks_; }
+
+private:
+    std::vector<uint8_t> mask_;
+    std::vector<uint32_t> candidates_;
+    std::vector<Peak> peaks_;
+};
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "percentile_average.h"
+
+#include <algorithm>
+
+PercentileAverage::PercentileAverage() :
+    bins_(0),
+    fraction_(0.5),
+    count_(0)
+{
+    std::fill(desired_, desired_+3, 0.0);
+    std::fill(increment_, increment_+3, 0.0);
+}
+
+void PercentileAverage::configure(size_t bins, double percentile){
+    bins_ = bins;
+    fraction_ = std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+    for (size_t i=0; i<5; i++)
+        height_[i].resize(bins);
+    for (size_t i=0; i<3; i++)
+        position_[i].resize(bins);
+    increment_[0] = fraction_/2;
+    increment_[1] = fraction_;
+    increment_[2] = (1+fraction_)/2;
+    reset();
+}
+
+void PercentileAverage::release(){
+    for (size_t i=0; i<5; i++)
+        RealHugeVector().swap(height_[i]);
+    for (size_t i=0; i<3; i++)
+        RealHugeVector().swap(position_[i]);
+    bins_ = 0;
+    count_ = 0;
+}
+
+void PercentileAverage::reset(){
+    count_ = 0;
+}
+
+namespace {
+    inline float binPower(const std::complex<float>& value){ return std::norm(value); }
+    inline float binPower(float power){ return power; }
+}
+
+void PercentileAverage::add(const std::complex<float>* fft){
+    update(fft);
+}
+
+void PercentileAverage::add(const float* power){
+    update(power);
+}
+
+template <class T>
+void PercentileAverage::update(const T* frame){
+    if (count_ < 5) {
+        float* slot = &height_[count_][0];
+        for (size_t i=0; i<bins_; i++)
+            slot[i] = binPower(frame[i]);
+        if (++count_ == 5)
+            start();
+        return;
+    }
+
+    // the outer markers track the extremes; each inner marker moves up one
+    // position when the new value falls below it
+    float* q0 = &height_[0][0];
+    float* q1 = &height_[1][0];
+    float* q2 = &height_[2][0];
+    float* q3 = &height_[3][0];
+    float* q4 = &height_[4][0];
+    float* n1 = &position_[0][0];
+    float* n2 = &position_[1][0];
+    float* n3 = &position_[2][0];
+    for (size_t i=0; i<bins_; i++) {
+        float x = binPower(frame[i]);
+        q0[i] = std::min(q0[i], x);
+        q4[i] = std::max(q4[i], x);
+        n1[i] += (x < q1[i]) ? 1.0f : 0.0f;
+        n2[i] += (x < q2[i]) ? 1.0f : 0.0f;
+        n3[i] += (x < q3[i]) ? 1.0f : 0.0f;
+    }
+    count_++;
+    for (size_t m=0; m<3; m++)
+        desired_[m] += increment_[m];
+
+    // each marker is adjusted against its already adjusted lower neighbor
+    for (size_t m=1; m<4; m++)
+        adjust(m);
+}
+
+void PercentileAverage::start(){
+    // sort the first five values of each bin into the initial markers
+    float* q[5];
+    for (size_t m=0; m<5; m++)
+        q[m] = &height_[m][0];
+    for (size_t i=0; i<bins_; i++) {
+        float v[5] = { q[0][i], q[1][i], q[2][i], q[3][i], q[4][i] };
+        std::sort(v, v+5);
+        for (size_t m=0; m<5; m++)
+            q[m][i] = v[m];
+    }
+    for (size_t m=0; m<3; m++) {
+        std::fill(position_[m].begin(), position_[m].end(), float(m+1));
+        desired_[m] = 4*increment_[m];
+    }
+}
+
+void PercentileAverage::adjust(size_t marker){
+    // positions are zero-based, so the last marker sits at count_-1
+    const float last = float(count_-1);
+    const float desired = float(desired_[marker-1]);
+    float* lower = &height_[marker-1][0];
+    float* height = &height_[marker][0];
+    float* upper = &height_[marker+1][0];
+    const float* lowerPos = (marker > 1) ? &position_[marker-2][0] : NULL;
+    float* pos = &position_[marker-1][0];
+    const float* upperPos = (marker < 3) ? &position_[marker][0] : NULL;
+
+    for (size_t i=0; i<bins_; i++) {
+        float nl = lowerPos ? lowerPos[i] : 0.0f;
+        float nu = upperPos ? upperPos[i] : last;
+        float n = pos[i];
+        float d = desired - n;
+        float step;
+        if (d >= 1.0f && nu-n > 1.0f)
+            step = 1.0f;
+        else if (d <= -1.0f && nl-n < -1.0f)
+            step = -1.0f;
+        else
+            continue;
+
+        // piecewise parabolic prediction, falling back to linear when it
+        // would leave the neighbors' range
+        float q = height[i];
+        float ql = lower[i];
+        float qu = upper[i];
+        float parabolic = q + step/(nu-nl) * ((n-nl+step)*(qu-q)/(nu-n) + (nu-n-step)*(q-ql)/(n-nl));
+        if (ql < parabolic && parabolic < qu) {
+            height[i] = parabolic;
+        } else if (step > 0) {
+            height[i] = q + (qu-q)/(nu-n);
+        } else {
+            height[i] = q - (ql-q)/(nl-n);
+        }
+        pos[i] = n + step;
+    }
+}
+
+void PercentileAverage::result(float* out){
+    if (count_ > 5) {
+        const float* q2 = &height_[2][0];
+        std::copy(q2, q2+bins_, out);
+        return;
+    }
+    if (count_ == 0)
+        return;
+
+    // few enough frames to interpolate between the sorted values
+    double rank = fraction_*(count_-1);
+    size_t below = size_t(rank);
+    size_t above = std::min(below+1, count_-1);
+    float weight = float(rank-below);
+    for (size_t i=0; i<bins_; i++) {
+        float v[5];
+        for (size_t m=0; m<count_; m++)
+            v[m] = height_[m][i];
+        if (count_ < 5)
+            std::sort(v, v+count_);
+        out[i] = v[below] + weight*(v[above]-v[below]);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef PERCENTILE_AVERAGE_H
+#define PERCENTILE_AVERAGE_H
+
+#include <complex>
+#include <cstddef>
+
+#include "huge_pages.h"
+
+class PercentileAverage
+{
+    //per-bin percentile of the power over a run of frames, estimated with
+    //the P-squared algorithm (Jain and Chlamtac), which keeps five markers
+    //per bin instead of the frames themselves
+    //
+    //every bin sees the same number of frames, so the desired marker
+    //positions are shared and only the marker heights and the three inner
+    //marker positions are kept per bin.  they are stored as one array per
+    //marker so that the update runs across bins
+public:
+    PercentileAverage();
+
+    // percentile in [0, 100]; drops the frames added so far
+    void configure(size_t bins, double percentile);
+    void release();
+
+    // start a new run of frames
+    void reset();
+
+    // add the power of one frame, from its spectrum or given directly
+    void add(const std::complex<float>* fft);
+    void add(const float* power);
+
+    size_t count() const { return count_; }
+    size_t bins() const { return bins_; }
+
+    // the estimated percentile of each bin over the frames added.  exact
+    // for up to five frames
+    void result(float* out);
+
+private:
+    template <class T>
+    void update(const T* frame);
+    void start();
+    void adjust(size_t marker);
+
+    size_t bins_;
+    double fraction_;
+    size_t count_;
+
+    // marker heights; until five frames have been added, the frames
+    // themselves in arrival order
+    RealHugeVector height_[5];
+    // positions of markers 1-3; markers 0 and 4 are always at the first
+    // and last frame
+    RealHugeVector position_[3];
+    // desired positions of markers 1-3 and their increment per frame
+    double desired_[3];
+    double increment_[3];
+};
+
+#endif
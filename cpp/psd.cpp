@@ -27,37 +27,102 @@
 
 #include "psd.h"
 
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
 PREPARE_LOGGING(PsdProcessor)
+PREPARE_LOGGING(CrossSpectralProcessor)
 PREPARE_LOGGING(psd_i)
 
 /****************************************************************
  ****************************************************************
  **                                                            **
- **                     Helper Methods                         **
+ **                   PsdProcessor class                       **
  **                                                            **
  ****************************************************************
  ****************************************************************/
+PsdResolution::PsdResolution(size_t fftSize,
+                    int overlap,
+                    size_t numAvg,
+                    float logCoeff,
+                    bulkio::OutFloatStream fftStream,
+                    bulkio::OutFloatStream psdStream,
+                    bulkio::OutShortStream fftShortStream) :
+        fftSz(fftSize),
+        strideSize(fftSize-overlap),
+        numAverage(numAvg),
+        numAvgSetting(numAvg),
+        rateAverage(0),
+        next(0),
+        engine(new PsdEngine(fftSize, numAvg, logCoeff)),
+        outFFT(fftStream),
+        outPSD(psdStream),
+        outFFTShort(fftShortStream){
+    engine->setStride(strideSize);
+}
 
-void copyVec(const bulkio::FloatDataBlock &block, RealFFTWVector &out){
-    out.resize(block.size());
-    memcpy(&out[0], block.data(), out.size()*sizeof(float));
+void PsdResolution::configure(size_t fftSize, size_t stride, size_t numAvg){
+    fftSz = fftSize;
+    strideSize = stride;
+    numAvgSetting = numAvg;
+    numAverage = std::max(numAvg, rateAverage);
+    engine->setFftSize(fftSize);
+    engine->setNumAvg(numAverage);
+    engine->setStride(stride);
 }
 
-void copyVec(const bulkio::FloatDataBlock &block, ComplexFFTWVector &out){
-    out.resize(block.cxsize());
-    memcpy(&out[0], block.data(), out.size()*sizeof(std::complex<float>));
+void PsdResolution::limitOutputRate(double xdelta, double maxRate){
+    rateAverage = 0;
+    if (maxRate > 0 && xdelta > 0 && strideSize > 0) {
+        // a frame is produced every stride samples
+        double frameRate = 1.0/(xdelta*strideSize);
+        rateAverage = size_t(ceil(frameRate/maxRate - 1e-9));
+    }
+    numAverage = std::max(numAvgSetting, rateAverage);
+    engine->setNumAvg(numAverage);
+}
+
+void PsdResolution::configureOutput(size_t framesPerPacket, double maxLatency){
+    fftFrames.configure(framesPerPacket, maxLatency, outFFT);
+    psdFrames.configure(framesPerPacket, maxLatency, outPSD);
+    fftShortFrames.configure(framesPerPacket, maxLatency, outFFTShort);
+}
+
+void PsdResolution::configureChanges(float threshold, float logCoeff, double keepAlive){
+    size_t frames = 0;
+    if (keepAlive > 0 && psdSRI.ydelta > 0)
+        frames = std::max<size_t>(1, size_t(ceil(keepAlive/psdSRI.ydelta - 1e-9)));
+    psdChanges.configure(threshold, logCoeff, frames);
+}
+
+void PsdResolution::flushOutput(bool force){
+    fftFrames.flush(outFFT, force);
+    psdFrames.flush(outPSD, force);
+    fftShortFrames.flush(outFFTShort, force);
+}
+
+void PsdResolution::close(){
+    flushOutput(true);
+    if(!!outFFT){
+        outFFT.close();
+    }
+    if(!!outPSD){
+        outPSD.close();
+    }
+    if(!!outFFTShort){
+        outFFTShort.close();
+    }
 }
 
-/****************************************************************
- ****************************************************************
- **                                                            **
- **                   PsdProcessor class                       **
- **                                                            **
- ****************************************************************
- ****************************************************************/
 PsdProcessor::PsdProcessor(bulkio::InFloatStream inStream,
                     bulkio::OutFloatStream fftStream,
                     bulkio::OutFloatStream psdStream,
+                    bulkio::OutFloatStream occupancyStream,
+                    bulkio::OutDoubleStream peakStream,
+                    bulkio::OutFloatStream acfStream,
+                    bulkio::OutFloatStream bandStream,
+                    bulkio::OutShortStream fftShortStream,
                     size_t fftSize,
                     int overlap,
                     size_t numAvg,
@@ -68,35 +133,82 @@ PsdProcessor::PsdProcessor(bulkio::InFloatStream inStream,
                     float delay) :
         ThreadedComponent(),
         in(inStream),
-        outFFT(fftStream),
-        outPSD(psdStream),
-        realPsd_(NULL),
-        complexPsd_(NULL),
-        vecMean_(numAvg, psdOut_, psdAverage_),
+        outOccupancy_(occupancyStream),
+        occupancyFrames_(0),
+        outPeaks_(peakStream),
+        peakCount_(0),
+        peakXstart_(0),
+        peakXdelta_(1),
+        outAcf_(acfStream),
+        acfActive_(false),
+        outBands_(bandStream),
+        bandsActive_(false),
+        suppressed_(0),
         eos(false),
         paramLock(new boost::mutex()){
     LOG_DEBUG(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID());
+    resolutions_.push_back(boost::shared_ptr<PsdResolution>(
+            new PsdResolution(fftSize, overlap, numAvg, logCoeff, fftStream, psdStream, fftShortStream)));
     params.fftSz = fftSize;
     params.fftSzChanged = true;
     params.strideSize=fftSize-overlap;
     params.numAverage = numAvg;
     params.numAverageChanged = true;
+    params.maxOutputRate = 0;
     params.overlap = overlap;
     params.doFFT = doFFT;
+    params.doFFTShort = false;
     params.doPSD = doPSD;
+    params.doOccupancy = false;
+    params.doPeaks = false;
+    params.doAcf = false;
+    params.doBands = false;
     params.rfFreqUnits = rfFreqUnits;
     params.logCoeff = logCoeff;
+    params.averageMode = PsdEngine::AVERAGE_MEAN;
+    params.percentile = 50.0;
+    params.tapers = 0;
+    params.bandwidth = 4.0;
+    params.packedReal = false;
+    params.framesPerPacket = 1;
+    params.maxLatency = 0;
+    params.occupancyThreshold = 0;
+    params.occupancyInterval = 0;
+    params.peakCount = 0;
+    params.peakInterpolation = true;
+    params.changeThreshold = 0;
+    params.changeKeepAlive = 0;
+    params.acfEnabled = false;
+    params.acfZeroPad = false;
     params.updateSRI = true; // force initial SRI push
+    params.historyBytes = 0;
+    params.historyChanged = false;
+    params.resolutionsChanged = false;
+    params.placementChanged = false;
+    params.reallocate = false;
     setThreadDelay(delay);
+}
+
+void PsdProcessor::start(){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__);
     ThreadedComponent::startThread();
 }
 PsdProcessor::~PsdProcessor(){
     LOG_DEBUG(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID());
-    if(!!outFFT){
-        outFFT.close();
+    for (size_t i=0; i<resolutions_.size(); i++) {
+        resolutions_[i]->close();
     }
-    if(!!outPSD){
-        outPSD.close();
+    if(!!outOccupancy_){
+        outOccupancy_.close();
+    }
+    if(!!outPeaks_){
+        outPeaks_.close();
+    }
+    if(!!outAcf_){
+        outAcf_.close();
+    }
+    if(!!outBands_){
+        outBands_.close();
     }
     flush();
 }
@@ -125,17 +237,77 @@ void PsdProcessor::updateNumAvg(size_t avg){
     params.updateSRI=true;
 }
 
+void PsdProcessor::updateMaxOutputRate(double rate){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID()<<" rate="<<rate);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.maxOutputRate = rate;
+    params.updateSRI=true;
+}
+
 void PsdProcessor::forceSRIUpdate(){
     LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID());
     boost::mutex::scoped_lock lock(*paramLock);
     params.updateSRI=true;
 }
 
-void PsdProcessor::updateActions(bool psd, bool fft){
-    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" psd:"<<psd<<" fft:"<<fft);
+void PsdProcessor::updateActions(bool psd, bool fft, bool fftShort, bool occupancy, bool peaks, bool acf, bool bands){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" psd:"<<psd<<" fft:"<<fft<<" fftShort:"<<fftShort
+              <<" occupancy:"<<occupancy<<" peaks:"<<peaks<<" acf:"<<acf<<" bands:"<<bands);
     boost::mutex::scoped_lock lock(*paramLock);
     params.doPSD = psd;
     params.doFFT = fft;
+    params.doFFTShort = fftShort;
+    // the derived outputs are set up with the SRI, so a change redoes it
+    if (occupancy != params.doOccupancy || peaks != params.doPeaks ||
+        acf != params.doAcf || bands != params.doBands) {
+        params.doOccupancy = occupancy;
+        params.doPeaks = peaks;
+        params.doAcf = acf;
+        params.doBands = bands;
+        params.updateSRI = true;
+    }
+}
+
+void PsdProcessor::updateHistory(const std::string& directory, size_t maxBytes){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" directory="<<directory<<" maxBytes="<<maxBytes);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.historyDir = directory;
+    params.historyBytes = maxBytes;
+    params.historyChanged = true;
+}
+
+void PsdProcessor::updateResolutions(const std::vector<boost::shared_ptr<PsdResolution> >& resolutions){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" count="<<resolutions.size());
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.resolutions = resolutions;
+    params.resolutionsChanged = true;
+    params.updateSRI=true;
+}
+
+void PsdProcessor::updateSparse(const std::vector<double>& frequencies, const std::vector<unsigned int>& bins){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" frequencies="<<frequencies.size()<<" bins="<<bins.size());
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.sparseFrequencies = frequencies;
+    params.sparseBins = bins;
+    params.updateSRI=true;
+}
+
+void PsdProcessor::updatePlacement(const ThreadPlacement& placement){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID());
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.placement = placement;
+    params.placementChanged = true;
+}
+
+void PsdProcessor::reallocate(){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID());
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.reallocate = true;
+}
+
+boost::shared_ptr<WaterfallHistory> PsdProcessor::history(){
+    boost::mutex::scoped_lock lock(*paramLock);
+    return history_;
 }
 
 void PsdProcessor::updateRfFreqUnits(bool enable){
@@ -145,6 +317,88 @@ void PsdProcessor::updateRfFreqUnits(bool enable){
     params.updateSRI=true;
 }
 
+void PsdProcessor::updateBatching(const boost::shared_ptr<FrameBatcherPool>& batching){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID());
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.batching = batching;
+}
+
+void PsdProcessor::updateCrossSpectral(const boost::shared_ptr<CrossSpectralProcessor>& crossSpectral){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" streamID="<<in.streamID());
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.crossSpectral = crossSpectral;
+}
+
+void PsdProcessor::updateAggregation(size_t framesPerPacket, double maxLatency){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" framesPerPacket="<<framesPerPacket<<" maxLatency="<<maxLatency);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.framesPerPacket = framesPerPacket;
+    params.maxLatency = maxLatency;
+}
+
+void PsdProcessor::updateAveraging(PsdEngine::AverageMode mode, double percentile){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" mode="<<mode<<" percentile="<<percentile);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.averageMode = mode;
+    params.percentile = percentile;
+}
+
+void PsdProcessor::updateMultitaper(size_t tapers, double bandwidth){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" tapers="<<tapers<<" bandwidth="<<bandwidth);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.tapers = tapers;
+    params.bandwidth = bandwidth;
+}
+
+void PsdProcessor::updateOccupancy(float threshold, double interval){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" threshold="<<threshold<<" interval="<<interval);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.occupancyThreshold = threshold;
+    params.occupancyInterval = interval;
+    params.updateSRI = true;
+}
+
+void PsdProcessor::updatePeaks(size_t count, bool interpolate){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" count="<<count<<" interpolate="<<interpolate);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.peakCount = count;
+    params.peakInterpolation = interpolate;
+    params.updateSRI = true;
+}
+
+void PsdProcessor::updateChangeOnly(float threshold, double keepAlive){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" threshold="<<threshold<<" keepAlive="<<keepAlive);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.changeThreshold = threshold;
+    params.changeKeepAlive = keepAlive;
+}
+
+void PsdProcessor::updateAutocorrelation(bool enable, bool zeroPad){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" enable="<<enable<<" zeroPad="<<zeroPad);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.acfEnabled = enable;
+    params.acfZeroPad = zeroPad;
+    params.updateSRI = true;
+}
+
+void PsdProcessor::updateBands(const std::vector<band_struct>& bands){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" bands="<<bands.size());
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.bands = bands;
+    params.updateSRI = true;
+}
+
+uint64_t PsdProcessor::suppressedFrames(){
+    boost::mutex::scoped_lock lock(*paramLock);
+    return suppressed_;
+}
+
+void PsdProcessor::updatePackedReal(bool enable){
+    LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" new value is "<<enable);
+    boost::mutex::scoped_lock lock(*paramLock);
+    params.packedReal = enable;
+}
+
 void PsdProcessor::updateLogCoefficient(float logCoeff){
     LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__<<" new value is "<<logCoeff);
     boost::mutex::scoped_lock lock(*paramLock);
@@ -166,15 +420,13 @@ void PsdProcessor::stop() throw (CORBA::SystemException, CF::Resource::StopError
 void PsdProcessor::flush(){
     LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__);
     boost::mutex::scoped_lock lock(*paramLock);
-    //delete the pointers - then on next data call when we start processing again
-    //the rest of the processing state is flushed
-    if (realPsd_!=NULL)
-        delete realPsd_;
-    if (complexPsd_!=NULL)
-        delete complexPsd_;
-
-    realPsd_ = NULL;
-    complexPsd_ = NULL;
+    input_.reset();
+    for (size_t i=0; i<resolutions_.size(); i++) {
+        resolutions_[i]->engine->flush();
+        resolutions_[i]->next = 0;
+    }
+    if (acfEngine_)
+        acfEngine_->flush();
 }
 
 int PsdProcessor::serviceFunction(){
@@ -193,132 +445,204 @@ int PsdProcessor::serviceFunction(){
         // reset global
         params.fftSzChanged = false;
         params.numAverageChanged = false;
+        params.historyChanged = false;
+        params.resolutionsChanged = false;
+        params.placementChanged = false;
+        params.reallocate = false;
         params.updateSRI = false; // always reset to false once addressed
     }
 
+    // placement has to be applied from the processing thread itself
+    if(params_cache.placementChanged){
+        LOG_TRACE(PsdProcessor,"serviceFunction - updating thread placement");
+        params_cache.placementChanged = false;
+        std::string error;
+        if (!applyThreadPlacement(params_cache.placement, error))
+            LOG_WARN(PsdProcessor, "Unable to apply thread placement for "<<in.streamID()<<": "<<error);
+        // rebuild the processing buffers so they are allocated on this thread's node
+        params_cache.reallocate = true;
+    }
+    if(params_cache.reallocate){
+        LOG_TRACE(PsdProcessor,"serviceFunction - reallocating processing buffers");
+        params_cache.reallocate = false;
+        for (size_t i=0; i<resolutions_.size(); i++) {
+            resolutions_[i]->engine->release();
+        }
+    }
+
     // update all data structures before processing, if needed
+    PsdResolution& primary = *resolutions_.front();
     if(params_cache.fftSzChanged){
         LOG_TRACE(PsdProcessor,"serviceFunction - updating data structures due to new fft size");
         params_cache.fftSzChanged = false;
-        if (realPsd_){
-            realIn_.resize(params_cache.fftSz);
-            psdOut_.resize(params_cache.fftSz/2+1);
-            fftOut_.resize(params_cache.fftSz/2+1);
-            realPsd_->setLength(params_cache.fftSz);
-        } else if (complexPsd_) {
-            complexIn_.resize(params_cache.fftSz);
-            psdOut_.resize(params_cache.fftSz);
-            fftOut_.resize(params_cache.fftSz);
-            complexPsd_->setLength(params_cache.fftSz);
-        }
     }
-
     if(params_cache.numAverageChanged){
         LOG_TRACE(PsdProcessor,"serviceFunction - updating data structures due to new num average");
         params_cache.numAverageChanged = false;
-        vecMean_.setAvgNum(params_cache.numAverage);
+    }
+    // once the stream is running, a new fft size is planned on a helper
+    // thread while the current transform keeps going; see the switch below
+    bool resizing = params_cache.fftSz != primary.fftSz && input_.end() > 0;
+    if (resizing) {
+        // the new engine is built with the current configuration, so that it
+        // neither computes its first frames the wrong way nor is replanned
+        // here once it is in use
+        PsdEngineSettings settings = engineSettings(params_cache.fftSz);
+        if (!builder_.building(params_cache.fftSz, settings, input_.complex())) {
+            LOG_DEBUG(PsdProcessor,"serviceFunction - planning fft size "<<params_cache.fftSz<<" in the background");
+            builder_.start(params_cache.fftSz, settings, input_.complex(), params_cache.placement);
+        }
+    } else {
+        builder_.cancel();
+        primary.configure(params_cache.fftSz, params_cache.strideSize, params_cache.numAverage);
+    }
+
+    if(params_cache.historyChanged){
+        LOG_TRACE(PsdProcessor,"serviceFunction - updating waterfall history");
+        params_cache.historyChanged = false;
+        boost::shared_ptr<WaterfallHistory> history;
+        if (!params_cache.historyDir.empty() && params_cache.historyBytes > 0) {
+            history.reset(new WaterfallHistory(WaterfallHistory::filename(params_cache.historyDir, in.streamID()),
+                                               params_cache.historyBytes));
+        }
+        boost::mutex::scoped_lock lock(*paramLock);
+        history_ = history;
+    }
+
+    if(params_cache.resolutionsChanged){
+        LOG_TRACE(PsdProcessor,"serviceFunction - updating additional resolutions");
+        params_cache.resolutionsChanged = false;
+        for (size_t i=1; i<resolutions_.size(); i++) {
+            resolutions_[i]->close();
+        }
+        resolutions_.resize(1);
+        for (size_t i=0; i<params_cache.resolutions.size(); i++) {
+            // new resolutions start with the next input packet
+            params_cache.resolutions[i]->next = std::max(input_.end(), primary.next);
+            resolutions_.push_back(params_cache.resolutions[i]);
+        }
+        params_cache.resolutions.clear();
+    }
+
+    for (size_t i=0; i<resolutions_.size(); i++) {
+        resolutions_[i]->engine->setLogCoefficient(params_cache.logCoeff);
+        resolutions_[i]->engine->setAveraging(params_cache.averageMode, params_cache.percentile);
+        resolutions_[i]->engine->setMultitaper(params_cache.tapers, params_cache.bandwidth);
+        resolutions_[i]->engine->setPackedReal(params_cache.packedReal);
+        // frames held back would break the even spacing of an aggregated
+        // packet, so change-only output is sent a frame at a time
+        size_t framesPerPacket = params_cache.changeThreshold > 0 ? 1 : params_cache.framesPerPacket;
+        resolutions_[i]->configureOutput(framesPerPacket, params_cache.maxLatency);
+        resolutions_[i]->configureChanges(params_cache.changeThreshold, params_cache.logCoeff,
+                                          params_cache.changeKeepAlive);
+    }
+
+    primary.engine->setOccupancy(params_cache.occupancyInterval > 0, occupancyThreshold());
+
+    // the padded frames are averaged like the primary psd
+    if (acfEngine_) {
+        acfEngine_->setNumAvg(primary.numAverage);
+        acfEngine_->setAveraging(params_cache.averageMode, params_cache.percentile);
     }
 
-    bulkio::FloatDataBlock block = in.tryread(params_cache.fftSz,params_cache.strideSize);
+    // the framing is done here for all resolutions, so take whatever the
+    // input stream has available
+    bulkio::FloatDataBlock block = in.tryread();
 
     if (!block) {
         if( in.eos()){
             LOG_DEBUG(PsdProcessor,"serviceFunction - got null block with EOS");
+            // NOTE - a partial frame (only at EOS) is zero padded to fftSz
+            for (size_t i=0; i<resolutions_.size(); i++)
+                processFrames(*resolutions_[i], true, i==0);
+            if (params_cache.crossSpectral)
+                params_cache.crossSpectral->endOfStream(in.streamID());
             eos=true;
             return FINISH;
         } else {
             LOG_DEBUG(PsdProcessor,"serviceFunction - got null block without EOS");
+            // a slow stream still updates within the latency limit
+            for (size_t i=0; i<resolutions_.size(); i++)
+                resolutions_[i]->flushOutput(false);
             return NOOP;
         }
     }
     LOG_DEBUG(PsdProcessor,"serviceFunction - got block of size "<<block.size());
 
+    // the cross-spectral group works from the same blocks
+    if (params_cache.crossSpectral)
+        params_cache.crossSpectral->push(in.streamID(), block);
+
     if (block.inputQueueFlushed()) {
         LOG_WARN(PsdProcessor, "Input queue flushed.  Flushing internal buffers.");
         //flush all our processor states if the queue flushed
         flush();
-    }
-
-    // TODO - what if we got a partial block w/o fftSz worth of data?
-
-    // do work and push out data
-    if (block.complex()) {
-
-        // setup Complex
-        if (realPsd_){
-            delete realPsd_;
-            realPsd_=NULL;
-        }
-        if (complexPsd_==NULL){
-            complexPsd_ = new ComplexPsd(complexIn_, psdOut_, fftOut_, params_cache.fftSz,true);
-            vecMean_.clear();
+    } else if (block.sriChanged() && input_.end() > input_.begin()) {
+        // finish whatever was buffered under the previous SRI
+        for (size_t i=0; i<resolutions_.size(); i++) {
+            processFrames(*resolutions_[i], true, i==0);
+            resolutions_[i]->next = 0;
         }
-
-        copyVec(block,complexIn_);
-        complexPsd_->run();
-
-    } else {
-
-        // setup Scalar
-        if (complexPsd_){
-            delete complexPsd_;
-            complexPsd_=NULL;
-        }
-        if (realPsd_==NULL){
-            realPsd_ = new RealPsd(realIn_, psdOut_, fftOut_, params_cache.fftSz,true);
-            vecMean_.clear();
-        }
-
-        copyVec(block,realIn_);
-        realPsd_->run();
+        input_.reset();
     }
 
-    float* psdOutPtr = NULL;
-    size_t psdOutLen = 0;
-    if (params_cache.doPSD){
-        if (params_cache.numAverage > 1){
-            if (vecMean_.run()){
-                psdOutPtr = &psdAverage_[0];
-                psdOutLen = psdAverage_.size();
-            }
-        } else {
-            psdOutPtr = &psdOut_[0];
-            psdOutLen = psdOut_.size();
-        }
-        //take the log of the output if necessary
-        if (params_cache.logCoeff > 0){
-            for (size_t i=0;i<psdOutLen;i++){
-                psdOutPtr[i]=params_cache.logCoeff*log10(psdOutPtr[i]);
-            }
+    // switch to the new transform between frames, with the SRI update for
+    // the new size going out with the first frame it produces
+    if (resizing) {
+        PsdEngine* engine = builder_.take();
+        if (engine) {
+            LOG_DEBUG(PsdProcessor,"serviceFunction - switching to fft size "<<params_cache.fftSz);
+            primary.engine.reset(engine);
+            primary.configure(params_cache.fftSz, params_cache.strideSize, params_cache.numAverage);
+            params_cache.updateSRI = true;
+            resizing = false;
         }
     }
 
-    std::complex<float>* fftOutPtr = NULL;
-    size_t fftOutLen = 0;
-    if (params_cache.doFFT){
-        fftOutPtr = &fftOut_[0];
-        fftOutLen = fftOut_.size();
-    }
-
     // Update SRI
-    if (params_cache.updateSRI || block.sriChanged()) {
+    // NOTE - a pending fft size change holds back its SRI update until the switch
+    if ((params_cache.updateSRI && !resizing) || block.sriChanged()) {
         params_cache.updateSRI = false; // always reset to false once addressed
         updateSRI(block);
     }
 
-    //output data
+    // with nothing connected and no history to feed, the data is dropped
+    // without being framed or transformed
+    if (!params_cache.doPSD && !params_cache.doFFT && !params_cache.doFFTShort && !history_ &&
+        (!params_cache.doOccupancy || params_cache.occupancyInterval <= 0) &&
+        (!params_cache.doPeaks || params_cache.peakCount == 0) &&
+        (!params_cache.doAcf || !params_cache.acfEnabled) &&
+        (!params_cache.doBands || params_cache.bands.empty())) {
+        if (input_.end() > 0) {
+            LOG_DEBUG(PsdProcessor,"serviceFunction - no consumers; discarding input");
+            input_.reset();
+            for (size_t i=0; i<resolutions_.size(); i++) {
+                resolutions_[i]->engine->flush();
+                resolutions_[i]->next = 0;
+            }
+            if (acfEngine_)
+                acfEngine_->flush();
+        }
+        if (in.eos()){
+            eos=true;
+            return FINISH;
+        }
+        return NORMAL;
+    }
+
     // NOTE - getTimeStamps() returns sorted list.
     //        First is guaranteed to be offset 0, and may or may not be synthetic.
     //        If any others, they will be non-synthetic.
-    // TODO - should adjust Timestamp for extra sample delay from elements in last loop
-    if (psdOutLen>0){
-        // we can assume params_cache.doPSD=true and psdOutPtr!=NULL if psdOutLen>0
-        outPSD.write(psdOutPtr, psdOutLen, block.getTimestamps().front().time);
-    }
-    if (fftOutLen>0){
-        // we can assume params_cache.doFFT=true and fftOutPtr!=NULL if fftOutLen>0
-        outFFT.write(fftOutPtr, fftOutLen, block.getTimestamps().front().time);
+    size_t samples = block.complex() ? block.cxsize() : block.size();
+    input_.append(block.data(), samples, block.complex(), block.getTimestamps().front().time, block.xdelta());
+
+    // do work and push out data
+    uint64_t needed = input_.end();
+    for (size_t i=0; i<resolutions_.size(); i++) {
+        processFrames(*resolutions_[i], in.eos(), i==0);
+        needed = std::min(needed, resolutions_[i]->next);
     }
+    input_.release(needed);
 
     if (in.eos()){
         LOG_TRACE(PsdProcessor,"serviceFunction - got EOS");
@@ -329,6 +653,147 @@ int PsdProcessor::serviceFunction(){
     return NORMAL;
 }
 
+void PsdProcessor::processFrames(PsdResolution& resolution, bool final, bool doHistory){
+    // the history, peaks, autocorrelation and band power are fed even when
+    // nobody is connected to the psd port
+    bool acfFromPsd = acfActive_ && !acfEngine_;
+    bool doPSD = params_cache.doPSD ||
+        (doHistory && (history_ || peakCount_ > 0 || acfFromPsd || bandsActive_));
+    bool complex = input_.complex();
+    size_t outLen = resolution.engine->outputLength(complex);
+
+    // small transforms are done up front, batched with other streams' frames
+    size_t batched = 0;
+    if (params_cache.batching && resolution.engine->sparseBins().empty() && !resolution.engine->packedReal() &&
+        !resolution.engine->multitaper()) {
+        resolution.batcher = params_cache.batching->get(resolution.fftSz, complex);
+        if (resolution.batcher)
+            batched = transformBatch(resolution, final, *resolution.batcher);
+    } else {
+        resolution.batcher.reset();
+    }
+    size_t frame = 0;
+
+    while (resolution.next < input_.end()) {
+        size_t samples = input_.available(resolution.next);
+        if (samples < resolution.fftSz && !final)
+            break;
+        if (resolution.next < input_.begin()) {
+            // previously released (e.g. after a flush); resume at the oldest sample
+            resolution.next = input_.begin();
+            continue;
+        }
+        samples = std::min(samples, resolution.fftSz);
+
+        // TODO - should adjust Timestamp for extra sample delay from elements in last loop
+        BULKIO::PrecisionUTCTime time = input_.time(resolution.next);
+
+        // the engine writes straight into pooled (and possibly aggregated)
+        // buffers which are then passed to the output streams by reference
+        std::complex<float>* fftDest = NULL;
+        if (params_cache.doFFT){
+            fftDest = resolution.fftFrames.slot(resolution.fftPool, outLen, time);
+        }
+        float* psdDest = NULL;
+        if (doPSD && resolution.engine->psdDue()){
+            psdDest = resolution.psdFrames.slot(resolution.psdPool, outLen, time);
+        }
+        bool psdReady;
+        if (frame < batched) {
+            std::complex<float>* spectrum = &resolution.batchSpectra[outLen*frame++];
+            if (fftDest)
+                std::copy(spectrum, spectrum+outLen, fftDest);
+            psdReady = resolution.engine->processSpectrum(spectrum, complex, doPSD, psdDest);
+        } else {
+            // with packed real transforms, the next frame is transformed
+            // along with this one when it is already complete
+            const float* following = NULL;
+            uint64_t nextFrame = resolution.next + resolution.strideSize;
+            if (!complex && resolution.engine->packedReal() && samples == resolution.fftSz &&
+                input_.available(nextFrame) >= resolution.fftSz) {
+                following = input_.data(nextFrame);
+            }
+            psdReady = resolution.engine->process(input_.data(resolution.next), samples, complex,
+                                                 doPSD, fftDest, psdDest, following);
+        }
+
+        // zero padded frames for the autocorrelation; the fft is of twice
+        // the size, so the lags do not wrap around
+        if (doHistory && acfActive_ && acfEngine_) {
+            if (acfEngine_->process(input_.data(resolution.next), samples, complex, true))
+                writeAutocorrelation(acfEngine_->psd(), 0, acfEngine_->fftSize(), resolution.fftSz, time);
+        }
+
+        // occupancy is only kept for the primary resolution
+        if (doHistory && occupancyFrames_ > 0) {
+            if (resolution.engine->occupancyFrames() == 1)
+                occupancyStart_ = time;
+            if (resolution.engine->occupancyFrames() >= occupancyFrames_)
+                writeOccupancy(resolution);
+        }
+
+        //output data
+        if (psdReady){
+            if (doHistory && history_)
+                history_->append(psdDest, outLen, time, resolution.psdSRI);
+            if (doHistory && peakCount_ > 0)
+                writePeaks(psdDest, outLen, time);
+            if (doHistory && bandsActive_)
+                writeBands(psdDest, time);
+            if (doHistory && acfFromPsd)
+                writeAutocorrelation(psdDest, params_cache.logCoeff, resolution.fftSz, resolution.fftSz, time);
+            if (params_cache.doPSD) {
+                if (resolution.psdChanges.pass(psdDest, outLen)) {
+                    resolution.psdFrames.commit(resolution.outPSD);
+                } else {
+                    boost::mutex::scoped_lock lock(*paramLock);
+                    suppressed_++;
+                }
+            }
+        }
+        if (params_cache.doFFT){
+            resolution.fftFrames.commit(resolution.outFFT);
+        }
+        if (params_cache.doFFTShort){
+            // the fft as computed, whether or not it went to a float output
+            const std::complex<float>* fft = fftDest ? fftDest : resolution.engine->fft();
+            short* shortFrame = resolution.fftShortFrames.slot(resolution.fftShortPool, 2*(outLen+1), time);
+            shortFrame[0] = blockfloat::convert(fft, outLen, shortFrame+2);
+            shortFrame[1] = 0;
+            resolution.fftShortFrames.commit(resolution.outFFTShort);
+        }
+
+        if (samples < resolution.fftSz) {
+            // only one zero-padded frame at the end
+            resolution.next = input_.end();
+            break;
+        }
+        resolution.next += resolution.strideSize;
+    }
+    resolution.flushOutput(final);
+}
+
+size_t PsdProcessor::transformBatch(PsdResolution& resolution, bool final, FrameBatcher& batcher){
+    // the same frames that processFrames() will take, in order
+    std::vector<const float*> frames;
+    std::vector<size_t> lengths;
+    uint64_t next = std::max(resolution.next, input_.begin());
+    while (next < input_.end()) {
+        size_t samples = input_.available(next);
+        if (samples < resolution.fftSz && !final)
+            break;
+        frames.push_back(input_.data(next));
+        lengths.push_back(std::min(samples, resolution.fftSz));
+        if (samples < resolution.fftSz)
+            break;
+        next += resolution.strideSize;
+    }
+    resolution.batchSpectra.resize(frames.size()*batcher.outputLength());
+    if (!frames.empty())
+        batcher.transform(&frames[0], &lengths[0], frames.size(), &resolution.batchSpectra[0]);
+    return frames.size();
+}
+
 void PsdProcessor::updateSRI(const bulkio::FloatDataBlock &block){
     LOG_TRACE(PsdProcessor,__PRETTY_FUNCTION__);
 
@@ -339,6 +804,303 @@ void PsdProcessor::updateSRI(const bulkio::FloatDataBlock &block){
         LOG_DEBUG(PsdProcessor,"SRI.mode changed");
     }
 
+    for (size_t i=0; i<resolutions_.size(); i++) {
+        updateSRI(block, *resolutions_[i]);
+    }
+    updateOccupancySRI(block);
+    updatePeakSRI();
+    updateAutocorrelationSRI(block);
+    updateBandSRI();
+}
+
+void PsdProcessor::updateOccupancySRI(const bulkio::FloatDataBlock &block){
+    // a partial count belongs to the old settings
+    PsdResolution& primary = *resolutions_.front();
+    primary.engine->resetOccupancy();
+    occupancyFrames_ = 0;
+    if (params_cache.occupancyInterval <= 0 || !params_cache.doOccupancy)
+        return;
+
+    // whole frames per summary, at least one
+    double frameSpacing = block.xdelta()*primary.strideSize;
+    occupancyFrames_ = 1;
+    if (frameSpacing > 0)
+        occupancyFrames_ = std::max<size_t>(1, size_t(ceil(params_cache.occupancyInterval/frameSpacing - 1e-9)));
+
+    // the psd frequency axis, one summary frame per interval
+    BULKIO::StreamSRI outputSRI = primary.psdSRI;
+    outputSRI.ydelta = frameSpacing*occupancyFrames_;
+    outputSRI.yunits = BULKIO::UNITS_TIME;
+    outputSRI.mode = 0;
+    CF::DataType keyword;
+    keyword.id = CORBA::string_dup("OCCUPANCY_THRESHOLD");
+    keyword.value <<= CORBA::Double(params_cache.occupancyThreshold);
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    keyword.id = CORBA::string_dup("OCCUPANCY_FRAMES");
+    keyword.value <<= CORBA::ULong(occupancyFrames_);
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    outOccupancy_.sri(outputSRI);
+}
+
+void PsdProcessor::writeOccupancy(PsdResolution& resolution){
+    redhawk::buffer<float> summary(resolution.engine->outputLength(input_.complex()));
+    resolution.engine->takeOccupancy(summary.data());
+    outOccupancy_.write(summary, occupancyStart_);
+}
+
+void PsdProcessor::updatePeakSRI(){
+    // the frequencies follow the primary psd output, including rf units;
+    // sparse output has no uniform axis to search
+    PsdResolution& primary = *resolutions_.front();
+    peakCount_ = 0;
+    if (params_cache.peakCount == 0 || !params_cache.doPeaks)
+        return;
+    if (!primary.engine->sparseBins().empty()) {
+        LOG_WARN(PsdProcessor, "peak output is not available with sparse frequencies or bins");
+        return;
+    }
+    peakCount_ = params_cache.peakCount;
+    peakXstart_ = primary.psdSRI.xstart;
+    peakXdelta_ = primary.psdSRI.xdelta;
+
+    // one packet of [frequency, power] pairs per psd frame, strongest first
+    BULKIO::StreamSRI outputSRI = primary.psdSRI;
+    outputSRI.xstart = 0;
+    outputSRI.xdelta = 1;
+    outputSRI.xunits = BULKIO::UNITS_NONE;
+    outputSRI.subsize = 2;
+    outputSRI.ystart = 0;
+    outputSRI.ydelta = 1;
+    outputSRI.yunits = BULKIO::UNITS_NONE;
+    outputSRI.mode = 0;
+    CF::DataType keyword;
+    keyword.id = CORBA::string_dup("PEAK_COUNT");
+    keyword.value <<= CORBA::ULong(peakCount_);
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    keyword.id = CORBA::string_dup("PEAK_FRAME_SPACING");
+    keyword.value <<= CORBA::Double(primary.psdSRI.ydelta);
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    outPeaks_.sri(outputSRI);
+}
+
+void PsdProcessor::writePeaks(const float* psd, size_t bins, const BULKIO::PrecisionUTCTime& time){
+    const std::vector<PeakFinder::Peak>& peaks = peakFinder_.find(psd, bins, peakCount_, params_cache.peakInterpolation);
+    redhawk::buffer<double> packet(2*peaks.size());
+    for (size_t i=0; i<peaks.size(); i++) {
+        packet[2*i] = peakXstart_ + peaks[i].bin*peakXdelta_;
+        packet[2*i+1] = peaks[i].power;
+    }
+    outPeaks_.write(packet, time);
+}
+
+void PsdProcessor::updateAutocorrelationSRI(const bulkio::FloatDataBlock &block){
+    PsdResolution& primary = *resolutions_.front();
+    acfActive_ = false;
+    if (!params_cache.acfEnabled || !params_cache.doAcf) {
+        acfEngine_.reset();
+        acf_.release();
+        return;
+    }
+    if (!primary.engine->sparseBins().empty()) {
+        LOG_WARN(PsdProcessor, "autocorrelation output is not available with sparse frequencies or bins");
+        acfEngine_.reset();
+        return;
+    }
+    acfActive_ = true;
+
+    // padding to twice the fft size leaves room for every lag of a frame
+    size_t fftSize = primary.fftSz;
+    if (params_cache.acfZeroPad) {
+        fftSize *= 2;
+        if (!acfEngine_ || acfEngine_->fftSize() != fftSize)
+            acfEngine_.reset(new PsdEngine(fftSize, primary.numAverage, 0));
+        acfEngine_->flush();
+    } else {
+        acfEngine_.reset();
+    }
+
+    // lags from -fftSize/2, in the units of the input sample spacing
+    BULKIO::StreamSRI outputSRI = primary.psdSRI;
+    outputSRI.xstart = -double(fftSize/2)*block.xdelta();
+    outputSRI.xdelta = block.xdelta();
+    outputSRI.xunits = BULKIO::UNITS_TIME;
+    outputSRI.subsize = fftSize;
+    outputSRI.mode = block.complex() ? 1 : 0;
+    CF::DataType keyword;
+    keyword.id = CORBA::string_dup("ACF_FRAME_LENGTH");
+    keyword.value <<= CORBA::ULong(primary.fftSz);
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    outAcf_.sri(outputSRI);
+}
+
+void PsdProcessor::writeAutocorrelation(const float* psd, float logCoeff, size_t fftSize, size_t frameLength,
+                                        const BULKIO::PrecisionUTCTime& time){
+    acf_.configure(fftSize, input_.complex());
+    redhawk::buffer<float> lags = acfPool_.allocate(acf_.outputLength());
+    acf_.transform(psd, logCoeff, frameLength, lags.data());
+    outAcf_.write(lags, time);
+}
+
+void PsdProcessor::updateBandSRI(){
+    PsdResolution& primary = *resolutions_.front();
+    bandsActive_ = false;
+    if (params_cache.bands.empty() || !params_cache.doBands)
+        return;
+    if (!primary.engine->sparseBins().empty()) {
+        LOG_WARN(PsdProcessor, "band power output is not available with sparse frequencies or bins");
+        return;
+    }
+
+    // band edges are in the same units as the psd xstart (i.e. rf if
+    // rfFreqUnits is set).  bands without a bin in the output are left out,
+    // rather than reported with no power
+    const BULKIO::StreamSRI& psdSRI = primary.psdSRI;
+    std::vector<double> starts;
+    std::vector<double> stops;
+    CORBA::StringSeq names;
+    CORBA::DoubleSeq startFreqs;
+    CORBA::DoubleSeq stopFreqs;
+    for (size_t i=0; i<params_cache.bands.size(); i++) {
+        const band_struct& band = params_cache.bands[i];
+        double start = std::min(band.startFrequency, band.stopFrequency);
+        double stop = std::max(band.startFrequency, band.stopFrequency);
+        double first = (start-psdSRI.xstart)/psdSRI.xdelta;
+        double last = (stop-psdSRI.xstart)/psdSRI.xdelta;
+        size_t firstBin, lastBin;
+        if (!BandPower::binRange(first, last, psdSRI.subsize, firstBin, lastBin)) {
+            LOG_WARN(PsdProcessor, "band '"<<band.name<<"' has no bins in the output band; ignoring it");
+            continue;
+        }
+        starts.push_back(first);
+        stops.push_back(last);
+        ossie::corba::push_back(names, CORBA::string_dup(band.name.c_str()));
+        ossie::corba::push_back(startFreqs, start);
+        ossie::corba::push_back(stopFreqs, stop);
+    }
+    if (starts.empty())
+        return;
+    bandPower_.configure(starts, stops, psdSRI.subsize);
+    bandsActive_ = true;
+
+    // one element per band, one frame per psd frame
+    BULKIO::StreamSRI outputSRI = psdSRI;
+    outputSRI.xstart = 0;
+    outputSRI.xdelta = 1;
+    outputSRI.xunits = BULKIO::UNITS_NONE;
+    outputSRI.subsize = bandPower_.bands();
+    outputSRI.mode = 0;
+    CF::DataType keyword;
+    keyword.id = CORBA::string_dup("BAND_NAMES");
+    keyword.value <<= names;
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    keyword.id = CORBA::string_dup("BAND_START_FREQUENCIES");
+    keyword.value <<= startFreqs;
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    keyword.id = CORBA::string_dup("BAND_STOP_FREQUENCIES");
+    keyword.value <<= stopFreqs;
+    ossie::corba::push_back(outputSRI.keywords, keyword);
+    outBands_.sri(outputSRI);
+}
+
+void PsdProcessor::writeBands(const float* psd, const BULKIO::PrecisionUTCTime& time){
+    redhawk::buffer<float> power(bandPower_.bands());
+    bandPower_.compute(psd, params_cache.logCoeff, power.data());
+    outBands_.write(power, time);
+}
+
+double PsdProcessor::outputStart(const BULKIO::StreamSRI& sri, const PsdFrequencyAxis& axis){
+    double ifStart = axis.xstart;
+    if (!params_cache.rfFreqUnits)
+        return ifStart;
+
+    //adjust the xstart for RF units if required
+    const redhawk::PropertyMap& props = redhawk::PropertyMap::cast(sri.keywords);
+    long rfCenter;
+    bool validRF = false;
+    if(props.find("CHAN_RF")!=props.end()){
+        rfCenter = props["CHAN_RF"].toLong();
+        validRF = true;
+    } else if(props.find("COL_RF")!=props.end()){
+        rfCenter = props["COL_RF"].toLong();
+        validRF = true;
+    }
+    if (!validRF){
+        LOG_WARN(PsdProcessor, "rf Frequency units requested but no rf unit keyword present");
+        return ifStart;
+    }
+    double ifCentre=0;
+    if (sri.mode == 0) //real data is at fs/4.0
+        ifCentre = 1.0/sri.xdelta/4.0;
+    double deltaF = rfCenter-ifCentre; //Translation between rf & if
+    return ifStart+deltaF;  //This the the start bin at RF
+}
+
+std::vector<double> PsdProcessor::sparsePositions(const PsdFrequencyAxis& axis, double xstart,
+                                                  CORBA::DoubleSeq& frequencies){
+    // positions of the sparse bins on the full output axis.  frequencies are
+    // in the same units as xstart (i.e. rf if rfFreqUnits is set)
+    std::vector<double> positions;
+    for (size_t i=0; i<params_cache.sparseFrequencies.size(); i++) {
+        double frequency = params_cache.sparseFrequencies[i];
+        double position = (frequency-xstart)/axis.xdelta;
+        if (position < 0 || position > axis.bins-1) {
+            LOG_WARN(PsdProcessor, "sparse frequency "<<frequency<<" is outside the output band");
+            continue;
+        }
+        positions.push_back(position);
+        ossie::corba::push_back(frequencies, frequency);
+    }
+    for (size_t i=0; i<params_cache.sparseBins.size(); i++) {
+        unsigned int bin = params_cache.sparseBins[i];
+        if (bin >= axis.bins) {
+            LOG_WARN(PsdProcessor, "sparse bin "<<bin<<" is outside the output ("<<axis.bins<<" bins)");
+            continue;
+        }
+        positions.push_back(bin);
+        ossie::corba::push_back(frequencies, xstart+bin*axis.xdelta);
+    }
+    return positions;
+}
+
+float PsdProcessor::occupancyThreshold() const{
+    // the threshold is in the units of the psd output; counting is done on
+    // linear power
+    float threshold = params_cache.occupancyThreshold;
+    if (params_cache.logCoeff > 0)
+        threshold = pow(10.0f, threshold/params_cache.logCoeff);
+    return threshold;
+}
+
+PsdEngineSettings PsdProcessor::engineSettings(size_t fftSize){
+    // the configuration of the primary engine at the given fft size, on the
+    // stream's current SRI
+    PsdEngineSettings settings;
+    settings.stride = params_cache.strideSize;
+    settings.numAvg = params_cache.numAverage;
+    settings.logCoeff = params_cache.logCoeff;
+    settings.averageMode = params_cache.averageMode;
+    settings.percentile = params_cache.percentile;
+    settings.tapers = params_cache.tapers;
+    settings.bandwidth = params_cache.bandwidth;
+    settings.packedReal = params_cache.packedReal;
+    settings.occupancy = params_cache.occupancyInterval > 0;
+    settings.occupancyThreshold = occupancyThreshold();
+    if (!params_cache.sparseFrequencies.empty() || !params_cache.sparseBins.empty()) {
+        BULKIO::StreamSRI sri = in.sri();
+        PsdFrequencyAxis axis(sri.xdelta, fftSize, sri.mode != 0);
+        CORBA::DoubleSeq frequencies;
+        settings.sparseBins = sparsePositions(axis, outputStart(sri, axis), frequencies);
+    }
+    return settings;
+}
+
+void PsdProcessor::updateSRI(const bulkio::FloatDataBlock &block, PsdResolution& resolution){
+    // frames collected so far belong to the old SRI
+    resolution.flushOutput(true);
+
+    // the averaging needed for the output rate limit follows the sample rate
+    resolution.limitOutputRate(block.xdelta(), params_cache.maxOutputRate);
+
     BULKIO::StreamSRI outputSRI;
 
     // Pass along any keywords that were in the source
@@ -349,57 +1111,317 @@ void PsdProcessor::updateSRI(const bulkio::FloatDataBlock &block){
     }
 
     double xdelta_in = block.xdelta();
-    outputSRI.xdelta = 1.0/(xdelta_in*params_cache.fftSz);
-
-    double ifStart = 0;
-    if (block.complex()) //complex Data
-        ifStart = -((params_cache.fftSz/2-1)*outputSRI.xdelta);
-
-    //adjust the xstart for RF units if required
-    if (params_cache.rfFreqUnits){
-        const redhawk::PropertyMap& props = redhawk::PropertyMap::cast(block.sri().keywords);
-        long rfCenter;
-        bool validRF = false;
-        if(props.find("CHAN_RF")!=props.end()){
-            rfCenter = props["CHAN_RF"].toLong();
-            validRF = true;
-        } else if(props.find("COL_RF")!=props.end()){
-            rfCenter = props["COL_RF"].toLong();
-            validRF = true;
-        }
-        if (validRF){
-            double ifCentre=0;
-            if (!block.complex()) //real data is at fs/4.0
-                ifCentre = 1.0/xdelta_in/4.0;
-            double deltaF = rfCenter-ifCentre; //Translation between rf & if
-            outputSRI.xstart = ifStart+deltaF;  //This the the start bin at RF
-        } else {
-            LOG_WARN(PsdProcessor, "rf Frequency units requested but no rf unit keyword present");
-            outputSRI.xstart = ifStart;
-        }
-    } else {
-        outputSRI.xstart = ifStart;
-    }
+    PsdFrequencyAxis axis(xdelta_in, resolution.fftSz, block.complex());
+    outputSRI.xdelta = axis.xdelta;
 
-    if (!block.complex())
-        outputSRI.subsize = params_cache.fftSz/2+1;
-    else
-        outputSRI.subsize =params_cache.fftSz;
-    outputSRI.ydelta = xdelta_in*params_cache.strideSize;
+    outputSRI.xstart = outputStart(block.sri(), axis);
+    outputSRI.subsize = axis.bins;
+    outputSRI.ydelta = xdelta_in*resolution.strideSize;
     outputSRI.yunits = BULKIO::UNITS_TIME;
     outputSRI.xunits = BULKIO::UNITS_FREQUENCY;
     outputSRI.mode = 1; //data is always complex out of the fft
 
-    // set/update the sri for the output FFT stream
-    outFFT.sri(outputSRI);
+    // sparse mode - only the requested bins are computed
+    CORBA::DoubleSeq sparseFreqs;
+    std::vector<double> positions = sparsePositions(axis, outputSRI.xstart, sparseFreqs);
+    resolution.engine->setSparseBins(positions);
+    if (!positions.empty()) {
+        // the output is no longer a uniform frequency axis; the frequency of
+        // each element is given by the SPARSE_FREQUENCIES keyword
+        outputSRI.subsize = positions.size();
+        outputSRI.xstart = 0;
+        outputSRI.xdelta = 1;
+        outputSRI.xunits = BULKIO::UNITS_NONE;
+        CF::DataType keyword;
+        keyword.id = CORBA::string_dup("SPARSE_FREQUENCIES");
+        keyword.value <<= sparseFreqs;
+        ossie::corba::push_back(outputSRI.keywords, keyword);
+    }
 
-    if (params_cache.numAverage > 2)
-        outputSRI.ydelta*=params_cache.numAverage;
+    // set/update the sri for the output FFT stream
+    resolution.outFFT.sri(outputSRI);
+
+    // the 16-bit fft has its exponent in an extra first element, placed one
+    // bin below the first so that the frequency axis still lines up
+    BULKIO::StreamSRI shortSRI = outputSRI;
+    shortSRI.xstart -= shortSRI.xdelta;
+    shortSRI.subsize += 1;
+    CF::DataType keyword;
+    keyword.id = CORBA::string_dup("BFP_EXPONENT_ELEMENTS");
+    keyword.value <<= CORBA::ULong(1);
+    ossie::corba::push_back(shortSRI.keywords, keyword);
+    resolution.outFFTShort.sri(shortSRI);
+
+    if (resolution.numAverage > 1)
+        outputSRI.ydelta*=resolution.numAverage;
 
     // set/update the sri for the output PSD stream
     outputSRI.mode = 0; //data is always real out of the psd
-    outPSD.sri(outputSRI);
+    resolution.outPSD.sri(outputSRI);
+    resolution.psdSRI = outputSRI;
+
+    // the first frame under a new SRI always goes out
+    resolution.psdChanges.reset();
+
+}
+
+/****************************************************************
+ ****************************************************************
+ **                                                            **
+ **               CrossSpectralProcessor class                 **
+ **                                                            **
+ ****************************************************************
+ ****************************************************************/
+CrossSpectralProcessor::CrossSpectralProcessor(const std::vector<std::string>& streamIDs,
+                    bulkio::OutFloatPort* csdPort,
+                    bulkio::OutFloatPort* coherencePort,
+                    size_t fftSize,
+                    int overlap,
+                    size_t numAvg,
+                    float delay) :
+        ThreadedComponent(),
+        streamIDs_(streamIDs),
+        channels_(streamIDs.size()),
+        engine_(streamIDs.size(), fftSize, numAvg),
+        fftSz_(fftSize),
+        strideSize_(fftSize-overlap),
+        numAverage_(numAvg),
+        framingChanged_(false),
+        aligned_(false),
+        dropping_(false),
+        haveSRI_(false),
+        eos(false){
+    LOG_DEBUG(CrossSpectralProcessor,__PRETTY_FUNCTION__<<" streams="<<streamIDs.size());
+    for (size_t p=0; p<engine_.pairs(); p++) {
+        size_t first, second;
+        engine_.pair(p, first, second);
+        std::string pairID = streamIDs_[first] + "_x_" + streamIDs_[second];
+        outCSD_.push_back(csdPort->createStream(pairID));
+        outCoherence_.push_back(coherencePort->createStream(pairID));
+    }
+    for (size_t i=0; i<channels_.size(); i++) {
+        channels_[i].ended = false;
+        channels_[i].xdelta = 0;
+        channels_[i].next = 0;
+    }
+    setThreadDelay(delay);
+    ThreadedComponent::startThread();
+}
+
+CrossSpectralProcessor::~CrossSpectralProcessor(){
+    LOG_DEBUG(CrossSpectralProcessor,__PRETTY_FUNCTION__);
+    for (size_t p=0; p<outCSD_.size(); p++) {
+        outCSD_[p].close();
+        outCoherence_[p].close();
+    }
+}
+
+void CrossSpectralProcessor::push(const std::string& streamID, const bulkio::FloatDataBlock& block){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__<<" streamID="<<streamID);
+    boost::mutex::scoped_lock lock(lock_);
+    for (size_t i=0; i<streamIDs_.size(); i++) {
+        if (streamIDs_[i] == streamID) {
+            channels_[i].blocks.push_back(block);
+            channels_[i].ended = false;
+        }
+    }
+}
+
+void CrossSpectralProcessor::endOfStream(const std::string& streamID){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__<<" streamID="<<streamID);
+    boost::mutex::scoped_lock lock(lock_);
+    for (size_t i=0; i<streamIDs_.size(); i++) {
+        if (streamIDs_[i] == streamID)
+            channels_[i].ended = true;
+    }
+}
+
+void CrossSpectralProcessor::updateFraming(size_t fftSize, int overlap, size_t numAvg){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__);
+    boost::mutex::scoped_lock lock(lock_);
+    fftSz_ = fftSize;
+    strideSize_ = fftSize-overlap;
+    numAverage_ = numAvg;
+    framingChanged_ = true;
+}
+
+bool CrossSpectralProcessor::finished(){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__);
+    return eos;
+}
+
+void CrossSpectralProcessor::stop() throw (CORBA::SystemException, CF::Resource::StopError){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__);
+    if (!ThreadedComponent::stopThread()) {
+        throw CF::Resource::StopError(CF::CF_NOTSET, "CrossSpectralProcessor thread did not die");
+    }
+}
+
+void CrossSpectralProcessor::flush(){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__);
+    for (size_t i=0; i<channels_.size(); i++) {
+        channels_[i].input.reset();
+        channels_[i].next = 0;
+    }
+    engine_.flush();
+    aligned_ = false;
+}
+
+void CrossSpectralProcessor::align(){
+    // start every channel at the sample closest to the latest first sample
+    BULKIO::PrecisionUTCTime start = channels_[0].input.time(channels_[0].input.begin());
+    for (size_t i=1; i<channels_.size(); i++) {
+        BULKIO::PrecisionUTCTime first = channels_[i].input.time(channels_[i].input.begin());
+        if (start < first)
+            start = first;
+    }
+    for (size_t i=0; i<channels_.size(); i++) {
+        SampleBuffer& input = channels_[i].input;
+        double offset = (start - input.time(input.begin())) / channels_[i].xdelta;
+        channels_[i].next = input.begin() + uint64_t(offset+0.5);
+        LOG_DEBUG(CrossSpectralProcessor,"Aligning "<<streamIDs_[i]<<" by "<<uint64_t(offset+0.5)<<" samples");
+    }
+    aligned_ = true;
+}
+
+void CrossSpectralProcessor::limitBuffering(){
+    size_t limit = std::max(fftSz_, strideSize_) * MAX_BUFFERED_FRAMES;
+    for (size_t i=0; i<channels_.size(); i++) {
+        SampleBuffer& input = channels_[i].input;
+        if (input.available(input.begin()) <= limit)
+            continue;
+        if (!dropping_) {
+            LOG_WARN(CrossSpectralProcessor, "Stream "<<streamIDs_[i]<<" is more than "<<MAX_BUFFERED_FRAMES
+                     <<" frames ahead of the rest of the cross-spectral group; dropping samples until it can be realigned");
+            dropping_ = true;
+        }
+        input.release(input.end() - limit);
+        // the partial average spans the samples dropped
+        engine_.flush();
+        aligned_ = false;
+    }
+}
+
+int CrossSpectralProcessor::serviceFunction(){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__);
+
+    // take the blocks pushed since the last pass.  a member has ended once
+    // its end of stream follows the last block it pushed
+    std::vector<std::deque<bulkio::FloatDataBlock> > blocks(channels_.size());
+    bool allEnded = true;
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        for (size_t i=0; i<channels_.size(); i++) {
+            blocks[i].swap(channels_[i].blocks);
+            if (!channels_[i].ended)
+                allEnded = false;
+        }
+        if (framingChanged_) {
+            framingChanged_ = false;
+            engine_.setFftSize(fftSz_);
+            engine_.setNumAvg(numAverage_);
+            if (haveSRI_)
+                updateSRI(sri_);
+        }
+    }
+
+    bool gotData = false;
+    for (size_t i=0; i<channels_.size(); i++) {
+        Channel& channel = channels_[i];
+        for (size_t b=0; b<blocks[i].size(); b++) {
+            const bulkio::FloatDataBlock& block = blocks[i][b];
+            gotData = true;
+            if (block.inputQueueFlushed()) {
+                LOG_WARN(CrossSpectralProcessor, "Input queue flushed.  Flushing internal buffers.");
+                flush();
+            }
+            if (i == 0 && (block.sriChanged() || !haveSRI_)) {
+                sri_ = block.sri();
+                haveSRI_ = true;
+                updateSRI(sri_);
+            }
+            size_t samples = block.complex() ? block.cxsize() : block.size();
+            channel.input.append(block.data(), samples, block.complex(),
+                                 block.getTimestamps().front().time, block.xdelta());
+            channel.xdelta = block.xdelta();
+        }
+    }
+
+    if (!aligned_) {
+        bool present = true;
+        for (size_t i=0; i<channels_.size(); i++) {
+            if (channels_[i].input.end() == channels_[i].input.begin())
+                present = false;
+        }
+        if (present)
+            align();
+    }
+
+    // frame all channels in lockstep
+    if (aligned_) {
+        bool complex = channels_[0].input.complex();
+        std::vector<const float*> frames(channels_.size());
+        while (true) {
+            bool ready = true;
+            for (size_t i=0; i<channels_.size(); i++) {
+                const SampleBuffer& input = channels_[i].input;
+                if (input.available(channels_[i].next) < fftSz_ || input.complex() != complex)
+                    ready = false;
+            }
+            if (!ready)
+                break;
+            for (size_t i=0; i<channels_.size(); i++)
+                frames[i] = channels_[i].input.data(channels_[i].next);
+
+            if (engine_.process(&frames[0], fftSz_, complex)) {
+                BULKIO::PrecisionUTCTime time = channels_[0].input.time(channels_[0].next);
+                size_t bins = engine_.outputLength(complex);
+                for (size_t p=0; p<outCSD_.size(); p++) {
+                    outCSD_[p].write(engine_.csd(p), bins, time);
+                    outCoherence_[p].write(engine_.coherence(p), bins, time);
+                }
+            }
+            for (size_t i=0; i<channels_.size(); i++)
+                channels_[i].next += strideSize_;
+            dropping_ = false;
+        }
+        for (size_t i=0; i<channels_.size(); i++)
+            channels_[i].input.release(channels_[i].next);
+    }
+    limitBuffering();
+
+    // everything that could still be aligned has been output above; a
+    // partial frame left on any member is dropped
+    if (allEnded) {
+        LOG_TRACE(CrossSpectralProcessor,"serviceFunction - every stream has ended");
+        eos=true;
+        return FINISH;
+    }
+    return gotData ? NORMAL : NOOP;
+}
+
+void CrossSpectralProcessor::updateSRI(const BULKIO::StreamSRI &inputSRI){
+    LOG_TRACE(CrossSpectralProcessor,__PRETTY_FUNCTION__);
+    bool complex = inputSRI.mode != 0;
+
+    BULKIO::StreamSRI outputSRI;
+    // Pass along any keywords that were in the first stream of the group
+    outputSRI.keywords = inputSRI.keywords;
+
+    PsdFrequencyAxis axis(inputSRI.xdelta, fftSz_, complex);
+    outputSRI.xdelta = axis.xdelta;
+    outputSRI.xstart = axis.xstart;
+    outputSRI.subsize = axis.bins;
+    outputSRI.ydelta = inputSRI.xdelta*strideSize_*std::max<size_t>(numAverage_, 1);
+    outputSRI.yunits = BULKIO::UNITS_TIME;
+    outputSRI.xunits = BULKIO::UNITS_FREQUENCY;
 
+    for (size_t p=0; p<outCSD_.size(); p++) {
+        outputSRI.mode = 1; //cross-spectra are complex
+        outCSD_[p].sri(outputSRI);
+        outputSRI.mode = 0; //coherence is real
+        outCoherence_[p].sri(outputSRI);
+    }
 }
 
 /****************************************************************
@@ -411,16 +1433,39 @@ void PsdProcessor::updateSRI(const bulkio::FloatDataBlock &block){
  ****************************************************************/
 psd_i::psd_i(const char *uuid, const char *label) :
    psd_base(uuid, label),
+   finishedSuppressed(0),
+   realInput_(false),
+   complexInput_(false),
+   placementCount(0),
+   replayCancel(false),
    doPSD(false),
    doFFT(false),
+   doFFTShort(false),
+   doOccupancy(false),
+   doPeaks(false),
+   doAcf(false),
+   doBands(false),
    listener(*this, &psd_i::callBackFunc)
 {
     psd_dataFloat_out->setNewConnectListener(&listener);
     fft_dataFloat_out->setNewConnectListener(&listener);
+    fft_dataShort_out->setNewConnectListener(&listener);
+    occupancy_dataFloat_out->setNewConnectListener(&listener);
+    peaks_dataDouble_out->setNewConnectListener(&listener);
+    acf_dataFloat_out->setNewConnectListener(&listener);
+    bands_dataFloat_out->setNewConnectListener(&listener);
+    psd_dataFloat_out->setNewDisconnectListener(&listener);
+    fft_dataFloat_out->setNewDisconnectListener(&listener);
+    fft_dataShort_out->setNewDisconnectListener(&listener);
+    occupancy_dataFloat_out->setNewDisconnectListener(&listener);
+    peaks_dataDouble_out->setNewDisconnectListener(&listener);
+    acf_dataFloat_out->setNewDisconnectListener(&listener);
+    bands_dataFloat_out->setNewDisconnectListener(&listener);
 }
 
 psd_i::~psd_i()
 {
+    stopReplays();
     clearThreads();
 }
 
@@ -432,8 +1477,48 @@ void psd_i::constructor()
     addPropertyListener(fftSize, this, &psd_i::fftSizeChanged);
     addPropertyListener(overlap, this, &psd_i::overlapChanged);
     addPropertyListener(numAvg, this, &psd_i::numAvgChanged);
+    addPropertyListener(maxOutputRate, this, &psd_i::maxOutputRateChanged);
+    addPropertyListener(averaging, this, &psd_i::averagingChanged);
+    addPropertyListener(averagingPercentile, this, &psd_i::averagingPercentileChanged);
+    addPropertyListener(multitaperTapers, this, &psd_i::multitaperChanged);
+    addPropertyListener(multitaperBandwidth, this, &psd_i::multitaperBandwidthChanged);
     addPropertyListener(rfFreqUnits, this, &psd_i::rfFreqUnitsChanged);
+    addPropertyListener(packedRealFft, this, &psd_i::packedRealFftChanged);
+    addPropertyListener(outputAggregation, this, &psd_i::outputAggregationChanged);
+    addPropertyListener(outputMaxLatency, this, &psd_i::outputMaxLatencyChanged);
+    addPropertyListener(occupancyThreshold, this, &psd_i::occupancyThresholdChanged);
+    addPropertyListener(occupancyInterval, this, &psd_i::occupancyIntervalChanged);
+    addPropertyListener(peakCount, this, &psd_i::peakCountChanged);
+    addPropertyListener(peakInterpolation, this, &psd_i::peakInterpolationChanged);
+    addPropertyListener(changeThreshold, this, &psd_i::changeThresholdChanged);
+    addPropertyListener(changeKeepAlive, this, &psd_i::changeKeepAliveChanged);
+    addPropertyListener(autocorrelation, this, &psd_i::autocorrelationChanged);
+    addPropertyListener(autocorrelationZeroPad, this, &psd_i::autocorrelationChanged);
+    addPropertyListener(bands, this, &psd_i::bandsChanged);
+    addPropertyListener(batchSize, this, &psd_i::batchSizeChanged);
+    addPropertyListener(batchMaxDelay, this, &psd_i::batchMaxDelayChanged);
     addPropertyListener(logCoefficient, this, &psd_i::logCoeffChanged);
+    addPropertyListener(historyDirectory, this, &psd_i::historyDirectoryChanged);
+    addPropertyListener(historySize, this, &psd_i::historySizeChanged);
+    addPropertyListener(historyReplay, this, &psd_i::historyReplayChanged);
+    addPropertyListener(resolutions, this, &psd_i::resolutionsChanged);
+    addPropertyListener(sparseFrequencies, this, &psd_i::sparseFrequenciesChanged);
+    addPropertyListener(sparseBins, this, &psd_i::sparseBinsChanged);
+    setPropertyQueryImpl(warmupComplete, this, &psd_i::getWarmupComplete);
+    addPropertyListener(hugePages, this, &psd_i::hugePagesChanged);
+    setPropertyQueryImpl(hugePageBacking, this, &psd_i::getHugePageBacking);
+    setPropertyQueryImpl(suppressedFrames, this, &psd_i::getSuppressedFrames);
+    addPropertyListener(cpuAffinity, this, &psd_i::cpuAffinityChanged);
+    addPropertyListener(affinityMode, this, &psd_i::affinityModeChanged);
+    addPropertyListener(numaLocal, this, &psd_i::numaLocalChanged);
+    addPropertyListener(realtimePriority, this, &psd_i::realtimePriorityChanged);
+
+    // listeners only see changes; apply the initial value here
+    hugePagesChanged("off", hugePages);
+
+    // plan the configured sizes before the first stream arrives
+    prewarm();
+    updateBatching();
 
     dataFloat_in->addStreamListener(this, &psd_i::streamAdded);
 }
@@ -579,12 +1664,18 @@ int psd_i::serviceFunction()
         for(map_type::iterator i = stateMap.begin();i!=stateMap.end();){
             if( i->second->finished() ){
                 LOG_DEBUG(psd_i,"Removing thread processor (eos): "<<i->first);
+                finishedSuppressed += i->second->suppressedFrames();
                 stateMap.erase(i++);
                 retval = NORMAL;
             } else {
                 ++i;
             }
         }
+        if (crossSpectral && crossSpectral->finished()) {
+            LOG_DEBUG(psd_i,"Removing cross-spectral processor (eos)");
+            crossSpectral.reset();
+            retval = NORMAL;
+        }
     }
 
     return retval;
@@ -593,15 +1684,61 @@ int psd_i::serviceFunction()
 void psd_i::streamAdded(bulkio::InFloatStream stream){
     LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
     boost::mutex::scoped_lock lock(stateMapLock);
+    {
+        // later size changes are only warmed for the input types in use
+        boost::mutex::scoped_lock warmLock(warmupLock);
+        if (stream.sri().mode != 0)
+            complexInput_ = true;
+        else
+            realInput_ = true;
+    }
     if (stateMap.find(stream.streamID())==stateMap.end()){
         LOG_DEBUG(psd_i,"Adding new thread processor: "<<stream.streamID());
         bulkio::OutFloatStream outputFFT = fft_dataFloat_out->createStream(stream.streamID());
         bulkio::OutFloatStream outputPSD = psd_dataFloat_out->createStream(stream.streamID());
+        bulkio::OutFloatStream outputOccupancy = occupancy_dataFloat_out->createStream(stream.streamID());
+        bulkio::OutDoubleStream outputPeaks = peaks_dataDouble_out->createStream(stream.streamID());
+        bulkio::OutFloatStream outputAcf = acf_dataFloat_out->createStream(stream.streamID());
+        bulkio::OutFloatStream outputBands = bands_dataFloat_out->createStream(stream.streamID());
+        bulkio::OutShortStream outputFFTShort = fft_dataShort_out->createStream(stream.streamID());
         boost::shared_ptr<PsdProcessor> newThread(
-                new PsdProcessor(stream, outputFFT, outputPSD, fftSize, overlap, numAvg,
+                new PsdProcessor(stream, outputFFT, outputPSD, outputOccupancy, outputPeaks, outputAcf, outputBands, outputFFTShort, fftSize, overlap, numAvg,
                         logCoefficient, doFFT, doPSD, rfFreqUnits));
+        newThread->updateActions(doPSD, doFFT, doFFTShort, doOccupancy, doPeaks, doAcf, doBands);
+        newThread->updateOccupancy(occupancyThreshold, occupancyInterval);
+        newThread->updatePeaks(peakCount, peakInterpolation);
+        newThread->updateChangeOnly(changeThreshold, changeKeepAlive);
+        newThread->updateAutocorrelation(autocorrelation, autocorrelationZeroPad);
+        newThread->updateBands(bands);
+        newThread->updateMaxOutputRate(maxOutputRate);
+        newThread->updateHistory(historyDirectory, historyBytes());
+        newThread->updateSparse(sparseFrequencies, std::vector<unsigned int>(sparseBins.begin(), sparseBins.end()));
+        newThread->updatePlacement(placement(placementCount++));
+        newThread->updatePackedReal(packedRealFft);
+        double percentile;
+        PsdEngine::AverageMode mode = averageMode(percentile);
+        newThread->updateAveraging(mode, percentile);
+        newThread->updateMultitaper(multitaperTapers, multitaperBandwidth);
+        newThread->updateBatching(batching_);
+        newThread->updateAggregation(outputAggregation, outputMaxLatency);
+        if (!resolutions.empty())
+            newThread->updateResolutions(createResolutions(stream.streamID()));
         map_type::value_type newEntry(stream.streamID(),newThread);
         stateMap.insert(stateMap.end(),newEntry);
+        if (crossSpectralStreams.size() > 1 &&
+            std::find(crossSpectralStreams.begin(), crossSpectralStreams.end(), stream.streamID()) != crossSpectralStreams.end()) {
+            if (!crossSpectral || crossSpectral->finished()) {
+                LOG_DEBUG(psd_i,"Adding new cross-spectral processor for "<<crossSpectralStreams.size()<<" streams");
+                crossSpectral.reset(new CrossSpectralProcessor(crossSpectralStreams, csd_dataFloat_out, coherence_dataFloat_out,
+                                                               fftSize, overlap, numAvg));
+                // members that are already running join the new group too
+                attachCrossSpectral();
+            } else {
+                newThread->updateCrossSpectral(crossSpectral);
+            }
+        }
+        // all settings are in place before the first block is read
+        newThread->start();
     } else {
         LOG_WARN(psd_i,"New stream with stream ID "<<stream.streamID()<<", but already have entry for that stream ID");
     }
@@ -621,16 +1758,33 @@ void psd_i::clearThreads(){
             i->second->stop();
         }
         stateMap.clear();
+        if (crossSpectral) {
+            crossSpectral->stop();
+            crossSpectral.reset();
+        }
+    }
+}
+
+void psd_i::attachCrossSpectral(){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    // stateMapLock is held by the caller
+    for(map_type::iterator i = stateMap.begin();i!=stateMap.end();i++){
+        if (!i->second->finished() &&
+            std::find(crossSpectralStreams.begin(), crossSpectralStreams.end(), i->first) != crossSpectralStreams.end())
+            i->second->updateCrossSpectral(crossSpectral);
     }
 }
 
 void psd_i::fftSizeChanged(unsigned int oldValue, unsigned int newValue){
     LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
     if (oldValue != newValue) {
+        prewarm();
         boost::mutex::scoped_lock lock(stateMapLock);
         for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++) {
             i->second->updateFftSize(fftSize);
         }
+        if (crossSpectral)
+            crossSpectral->updateFraming(fftSize, overlap, numAvg);
     }
 }
 
@@ -640,7 +1794,79 @@ void psd_i::numAvgChanged(unsigned int oldValue, unsigned int newValue){
         boost::mutex::scoped_lock lock(stateMapLock);
         for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
             i->second->updateNumAvg(numAvg);
+        if (crossSpectral)
+            crossSpectral->updateFraming(fftSize, overlap, numAvg);
+    }
+}
+
+void psd_i::maxOutputRateChanged(double oldValue, double newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateMaxOutputRate(maxOutputRate);
+    }
+}
+
+void psd_i::averagingChanged(const std::string& oldValue, const std::string& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (newValue != "mean" && newValue != "median" && newValue != "percentile") {
+        LOG_WARN(psd_i,"Invalid averaging '"<<newValue<<"'; using mean");
+    }
+    if (oldValue != newValue) {
+        double percentile;
+        PsdEngine::AverageMode mode = averageMode(percentile);
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateAveraging(mode, percentile);
+    }
+}
+
+void psd_i::averagingPercentileChanged(double oldValue, double newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (newValue < 0 || newValue > 100) {
+        LOG_WARN(psd_i,"averagingPercentile "<<newValue<<" is outside [0, 100]; clamping");
+    }
+    if (oldValue != newValue) {
+        double percentile;
+        PsdEngine::AverageMode mode = averageMode(percentile);
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateAveraging(mode, percentile);
+    }
+}
+
+PsdEngine::AverageMode psd_i::averageMode(double& percentile) const{
+    percentile = std::min(std::max(averagingPercentile, 0.0), 100.0);
+    if (averaging == "median") {
+        percentile = 50.0;
+        return PsdEngine::AVERAGE_PERCENTILE;
+    } else if (averaging == "percentile") {
+        return PsdEngine::AVERAGE_PERCENTILE;
+    }
+    return PsdEngine::AVERAGE_MEAN;
+}
+
+void psd_i::multitaperChanged(unsigned int oldValue, unsigned int newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updateMultitaper();
+}
+
+void psd_i::multitaperBandwidthChanged(double oldValue, double newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updateMultitaper();
+}
+
+void psd_i::updateMultitaper(){
+    if (multitaperTapers > 0 && (multitaperBandwidth <= 0 || multitaperTapers > 2*multitaperBandwidth)) {
+        LOG_WARN(psd_i,"multitaperTapers "<<multitaperTapers<<" with multitaperBandwidth "<<multitaperBandwidth
+                 <<": tapers beyond 2*NW are poorly concentrated");
     }
+    boost::mutex::scoped_lock lock(stateMapLock);
+    for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+        i->second->updateMultitaper(multitaperTapers, multitaperBandwidth);
 }
 
 void psd_i::overlapChanged(int oldValue, int newValue){
@@ -649,6 +1875,8 @@ void psd_i::overlapChanged(int oldValue, int newValue){
         boost::mutex::scoped_lock lock(stateMapLock);
         for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
             i->second->updateOverlap(overlap);
+        if (crossSpectral)
+            crossSpectral->updateFraming(fftSize, overlap, numAvg);
     }
 }
 
@@ -661,6 +1889,129 @@ void psd_i::rfFreqUnitsChanged(bool oldValue, bool newValue){
     }
 }
 
+void psd_i::packedRealFftChanged(bool oldValue, bool newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updatePackedReal(packedRealFft);
+    }
+}
+
+void psd_i::outputAggregationChanged(unsigned int oldValue, unsigned int newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateAggregation(outputAggregation, outputMaxLatency);
+    }
+}
+
+void psd_i::outputMaxLatencyChanged(double oldValue, double newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateAggregation(outputAggregation, outputMaxLatency);
+    }
+}
+
+void psd_i::occupancyThresholdChanged(float oldValue, float newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateOccupancy(occupancyThreshold, occupancyInterval);
+    }
+}
+
+void psd_i::occupancyIntervalChanged(double oldValue, double newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateOccupancy(occupancyThreshold, occupancyInterval);
+    }
+}
+
+void psd_i::peakCountChanged(unsigned int oldValue, unsigned int newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updatePeaks(peakCount, peakInterpolation);
+    }
+}
+
+void psd_i::peakInterpolationChanged(bool oldValue, bool newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updatePeaks(peakCount, peakInterpolation);
+    }
+}
+
+void psd_i::changeThresholdChanged(float oldValue, float newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateChangeOnly(changeThreshold, changeKeepAlive);
+    }
+}
+
+void psd_i::changeKeepAliveChanged(double oldValue, double newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateChangeOnly(changeThreshold, changeKeepAlive);
+    }
+}
+
+void psd_i::autocorrelationChanged(bool oldValue, bool newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateAutocorrelation(autocorrelation, autocorrelationZeroPad);
+    }
+}
+
+void psd_i::bandsChanged(const std::vector<band_struct>& oldValue, const std::vector<band_struct>& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateBands(bands);
+    }
+}
+
+void psd_i::batchSizeChanged(unsigned int oldValue, unsigned int newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updateBatching();
+}
+
+void psd_i::batchMaxDelayChanged(double oldValue, double newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updateBatching();
+}
+
+void psd_i::updateBatching(){
+    boost::mutex::scoped_lock lock(stateMapLock);
+    if (batchSize > 1) {
+        // a new pool, so that batches of the old size drain normally
+        batching_.reset(new FrameBatcherPool(batchSize, std::max(batchMaxDelay, 0.0)));
+    } else {
+        batching_.reset();
+    }
+    for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+        i->second->updateBatching(batching_);
+}
+
 void psd_i::logCoeffChanged(float oldValue, float newValue){
     LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
     if (oldValue != newValue) {
@@ -670,6 +2021,298 @@ void psd_i::logCoeffChanged(float oldValue, float newValue){
     }
 }
 
+void psd_i::sparseFrequenciesChanged(const std::vector<double>& oldValue, const std::vector<double>& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateSparse(sparseFrequencies, std::vector<unsigned int>(sparseBins.begin(), sparseBins.end()));
+    }
+}
+
+void psd_i::sparseBinsChanged(const std::vector<CORBA::ULong>& oldValue, const std::vector<CORBA::ULong>& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateSparse(sparseFrequencies, std::vector<unsigned int>(sparseBins.begin(), sparseBins.end()));
+    }
+}
+
+void psd_i::prewarm(){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    std::vector<size_t> sizes(1, fftSize);
+    for (size_t i=0; i<resolutions.size(); i++) {
+        if (resolutions[i].fftSize > 0)
+            sizes.push_back(resolutions[i].fftSize);
+    }
+    boost::mutex::scoped_lock lock(warmupLock);
+    // the input type isn't known until a stream arrives, so until then plan
+    // both
+    bool real = realInput_ || !complexInput_;
+    bool complex = complexInput_ || !realInput_;
+
+    // a size and type already planned or being planned is kept as it is
+    warmup_map warmup;
+    for (size_t i=0; i<sizes.size(); i++) {
+        for (int type=0; type<2; type++) {
+            if ((type && !complex) || (!type && !real))
+                continue;
+            warmup_map::key_type key(sizes[i], type != 0);
+            warmup_map::iterator current = warmup_.find(key);
+            if (current != warmup_.end()) {
+                warmup[key] = current->second;
+            } else if (warmup.find(key) == warmup.end()) {
+                boost::shared_ptr<PsdEngineBuilder> builder(new PsdEngineBuilder());
+                builder->warm(key.first, key.first, key.second);
+                warmup[key] = builder;
+            }
+        }
+    }
+    // sizes that are no longer configured are not planned if they have not
+    // started yet
+    for (warmup_map::iterator i = warmup_.begin(); i != warmup_.end(); i++) {
+        if (warmup.find(i->first) == warmup.end())
+            i->second->cancel();
+    }
+    warmup_.swap(warmup);
+}
+
+bool psd_i::getWarmupComplete(){
+    boost::mutex::scoped_lock lock(warmupLock);
+    for (warmup_map::iterator i = warmup_.begin(); i != warmup_.end(); i++) {
+        if (!i->second->ready())
+            return false;
+    }
+    return true;
+}
+
+void psd_i::hugePagesChanged(const std::string& oldValue, const std::string& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    hugepages::Mode mode;
+    if (!hugepages::parseMode(newValue, mode)) {
+        LOG_WARN(psd_i,"Invalid hugePages '"<<newValue<<"'; using off");
+        mode = hugepages::MODE_OFF;
+    }
+    if (mode == hugepages::mode())
+        return;
+    hugepages::setMode(mode);
+    // only new allocations pick up the mode, so have every processor rebuild
+    // its buffers
+    boost::mutex::scoped_lock lock(stateMapLock);
+    for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+        i->second->reallocate();
+}
+
+std::string psd_i::getHugePageBacking(){
+    return hugepages::backing();
+}
+
+CORBA::ULongLong psd_i::getSuppressedFrames(){
+    boost::mutex::scoped_lock lock(stateMapLock);
+    uint64_t total = finishedSuppressed;
+    for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+        total += i->second->suppressedFrames();
+    return total;
+}
+
+ThreadPlacement psd_i::placement(size_t index) const{
+    ThreadPlacement result;
+    if (!parseCpuList(cpuAffinity, result.cpus)) {
+        LOG_WARN(psd_i,"Invalid cpuAffinity '"<<cpuAffinity<<"'; not pinning threads");
+        result.cpus.clear();
+    }
+    if (affinityMode == "roundrobin" && !result.cpus.empty()) {
+        // one cpu per processor, in turn
+        int cpu = result.cpus[index % result.cpus.size()];
+        result.cpus.assign(1, cpu);
+    }
+    result.numaLocal = numaLocal;
+    result.priority = realtimePriority;
+    return result;
+}
+
+void psd_i::updatePlacements(){
+    boost::mutex::scoped_lock lock(stateMapLock);
+    placementCount = 0;
+    for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+        i->second->updatePlacement(placement(placementCount++));
+}
+
+void psd_i::cpuAffinityChanged(const std::string& oldValue, const std::string& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updatePlacements();
+}
+
+void psd_i::affinityModeChanged(const std::string& oldValue, const std::string& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updatePlacements();
+}
+
+void psd_i::numaLocalChanged(bool oldValue, bool newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updatePlacements();
+}
+
+void psd_i::realtimePriorityChanged(unsigned short oldValue, unsigned short newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue)
+        updatePlacements();
+}
+
+void psd_i::resolutionsChanged(const std::vector<resolution_struct>& oldValue, const std::vector<resolution_struct>& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        prewarm();
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateResolutions(createResolutions(i->first));
+    }
+}
+
+std::vector<boost::shared_ptr<PsdResolution> > psd_i::createResolutions(const std::string& streamID){
+    std::vector<boost::shared_ptr<PsdResolution> > result;
+    for (size_t i=0; i<resolutions.size(); i++) {
+        const resolution_struct& config = resolutions[i];
+        if (config.fftSize == 0 || config.overlap >= int(config.fftSize)) {
+            LOG_WARN(psd_i,"Ignoring resolution "<<i+1<<": fftSize="<<config.fftSize<<" overlap="<<config.overlap);
+            continue;
+        }
+        std::ostringstream resolutionID;
+        resolutionID << streamID << "_res" << i+1;
+        bulkio::OutFloatStream outputFFT = fft_dataFloat_out->createStream(resolutionID.str());
+        bulkio::OutFloatStream outputPSD = psd_dataFloat_out->createStream(resolutionID.str());
+        bulkio::OutShortStream outputFFTShort = fft_dataShort_out->createStream(resolutionID.str());
+        result.push_back(boost::shared_ptr<PsdResolution>(
+                new PsdResolution(config.fftSize, config.overlap, config.numAvg,
+                                  logCoefficient, outputFFT, outputPSD, outputFFTShort)));
+    }
+    return result;
+}
+
+size_t psd_i::historyBytes() const{
+    if (historyDirectory.empty())
+        return 0;
+    return size_t(historySize)*1024*1024;
+}
+
+void psd_i::historyDirectoryChanged(const std::string& oldValue, const std::string& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateHistory(historyDirectory, historyBytes());
+    }
+}
+
+void psd_i::historySizeChanged(unsigned int oldValue, unsigned int newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    if (oldValue != newValue) {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
+            i->second->updateHistory(historyDirectory, historyBytes());
+    }
+}
+
+void psd_i::historyReplayChanged(const historyReplay_struct& oldValue, const historyReplay_struct& newValue){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    // every request is acted upon, even if it repeats the previous one.  a
+    // replay can take a while, so it runs on its own thread rather than in
+    // the configure call.  historyDirectory is copied here, under the
+    // property lock, since configure may change it while the replay runs
+    if (newValue.streamID.empty())
+        return;
+    boost::mutex::scoped_lock lock(replayLock);
+    for (size_t i=0; i<replays_.size();) {
+        if (replays_[i]->timed_join(boost::posix_time::seconds(0))) {
+            replays_.erase(replays_.begin()+i);
+        } else {
+            i++;
+        }
+    }
+    replays_.push_back(boost::shared_ptr<boost::thread>(
+        new boost::thread(boost::bind(&psd_i::replayHistory, this, newValue, historyDirectory))));
+}
+
+bool psd_i::replayCancelled(){
+    boost::mutex::scoped_lock lock(replayLock);
+    return replayCancel;
+}
+
+void psd_i::stopReplays(){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
+    std::vector<boost::shared_ptr<boost::thread> > replays;
+    {
+        boost::mutex::scoped_lock lock(replayLock);
+        replayCancel = true;
+        replays.swap(replays_);
+    }
+    for (size_t i=0; i<replays.size(); i++)
+        replays[i]->join();
+}
+
+void psd_i::replayHistory(historyReplay_struct request, std::string directory){
+    LOG_TRACE(psd_i,__PRETTY_FUNCTION__<<" streamID="<<request.streamID);
+
+    // prefer the live history of an active stream; otherwise fall back to the
+    // file left behind by a finished one
+    boost::shared_ptr<WaterfallHistory> history;
+    {
+        boost::mutex::scoped_lock lock(stateMapLock);
+        map_type::iterator i = stateMap.find(request.streamID);
+        if (i != stateMap.end())
+            history = i->second->history();
+    }
+    if (!history) {
+        if (directory.empty()) {
+            LOG_WARN(psd_i,"History replay requested for "<<request.streamID<<" but historyDirectory is not set");
+            return;
+        }
+        history.reset(new WaterfallHistory(WaterfallHistory::filename(directory, request.streamID), 0));
+    }
+
+    // frames are copied out of the ring and sent one at a time, so a long
+    // range needs no more memory than a frame
+    WaterfallHistory::Cursor cursor;
+    WaterfallHistory::Frame frame;
+    WaterfallHistory::Frame previous;
+    size_t count = 0;
+    if (history->find(request.startTime, request.stopTime, cursor)) {
+        if (!request.exportFile.empty()) {
+            HistoryExport file;
+            while (!replayCancelled() && history->next(cursor, frame)) {
+                if (count == 0 && !file.open(request.exportFile))
+                    break;
+                file.write(frame);
+                count++;
+            }
+            file.close();
+        } else {
+            std::string replayID = request.streamID + "_replay";
+            bulkio::OutFloatStream replay;
+            while (!replayCancelled() && history->next(cursor, frame)) {
+                if (count == 0) {
+                    replay = psd_dataFloat_out->createStream(replayID);
+                    replay.sri(frame.sri(replayID));
+                } else if (!frame.sameSRI(previous)) {
+                    replay.sri(frame.sri(replayID));
+                }
+                replay.write(&frame.data[0], frame.data.size(), frame.time());
+                previous.record = frame.record;
+                count++;
+            }
+            if (!!replay)
+                replay.close();
+        }
+    }
+    LOG_DEBUG(psd_i,"Replayed "<<count<<" history frames for "<<request.streamID);
+    if (count == 0)
+        LOG_WARN(psd_i,"No history frames for "<<request.streamID<<" in ["<<request.startTime<<", "<<request.stopTime<<"]");
+}
+
 void psd_i::callBackFunc( const char* connectionId){
     LOG_TRACE(psd_i,__PRETTY_FUNCTION__);
     bool doUpdate = false;
@@ -681,9 +2324,29 @@ void psd_i::callBackFunc( const char* connectionId){
         doFFT = !doFFT;
         doUpdate = true;
     }
+    if(doFFTShort != (fft_dataShort_out->state()!=BULKIO::IDLE)){
+        doFFTShort = !doFFTShort;
+        doUpdate = true;
+    }
+    if(doOccupancy != (occupancy_dataFloat_out->state()!=BULKIO::IDLE)){
+        doOccupancy = !doOccupancy;
+        doUpdate = true;
+    }
+    if(doPeaks != (peaks_dataDouble_out->state()!=BULKIO::IDLE)){
+        doPeaks = !doPeaks;
+        doUpdate = true;
+    }
+    if(doAcf != (acf_dataFloat_out->state()!=BULKIO::IDLE)){
+        doAcf = !doAcf;
+        doUpdate = true;
+    }
+    if(doBands != (bands_dataFloat_out->state()!=BULKIO::IDLE)){
+        doBands = !doBands;
+        doUpdate = true;
+    }
     if(doUpdate){
         boost::mutex::scoped_lock lock(stateMapLock);
         for (map_type::iterator i = stateMap.begin(); i!=stateMap.end(); i++)
-            i->second->updateActions(doPSD, doFFT);
+            i->second->updateActions(doPSD, doFFT, doFFTShort, doOccupancy, doPeaks, doAcf, doBands);
     }
 }
@@ -19,11 +19,90 @@
 #ifndef PSD_IMPL_H
 #define PSD_IMPL_H
 
+#include <deque>
+#include <boost/scoped_ptr.hpp>
+
 #include "psd_base.h"
-#include "fft.h"
-#include "framebuffer.h"
-#include "vectormean.h"
+#include "autocorrelation.h"
+#include "band_power.h"
+#include "block_float.h"
+#include "buffer_pool.h"
+#include "change_filter.h"
+#include "psd_engine.h"
+#include "cross_spectral.h"
+#include "frame_aggregator.h"
+#include "frame_batcher.h"
+#include "sample_buffer.h"
+#include "huge_pages.h"
+#include "peak_finder.h"
+#include "thread_placement.h"
+#include "waterfall_history.h"
+
+
+class PsdResolution
+{
+    //one fft/psd product of an input stream: its framing, engine and
+    //output streams.  every resolution of a stream is framed from the same
+    //SampleBuffer
+public:
+    PsdResolution(size_t fftSize, int overlap, size_t numAvg, float logCoeff,
+                  bulkio::OutFloatStream fftStream, bulkio::OutFloatStream psdStream,
+                  bulkio::OutShortStream fftShortStream);
+
+    void configure(size_t fftSize, size_t strideSize, size_t numAvg);
+    // average enough psd frames to stay under maxRate frames per second
+    // (no limit if 0) for input with the given sample spacing
+    void limitOutputRate(double xdelta, double maxRate);
+    void configureOutput(size_t framesPerPacket, double maxLatency);
+    // hold back psd frames that differ from the last one sent by no more
+    // than threshold dB, sending one at least every keepAlive seconds
+    void configureChanges(float threshold, float logCoeff, double keepAlive);
+    // write out aggregated frames; unless forced, only those past the latency limit
+    void flushOutput(bool force);
+    void close();
+
+    size_t fftSz;
+    size_t strideSize;
+    // frames averaged per psd output: the configured numAvg, raised as
+    // needed by the output rate limit
+    size_t numAverage;
+    size_t numAvgSetting;
+    size_t rateAverage;
+
+    // absolute input index of the next frame's first sample
+    uint64_t next;
+
+    // fft/psd processing, averaging and log
+    boost::scoped_ptr<PsdEngine> engine;
+
+    // batcher shared with other streams, held while it is in use
+    boost::shared_ptr<FrameBatcher> batcher;
+    // spectra of the frames transformed by a FrameBatcher
+    std::vector<std::complex<float> > batchSpectra;
+
+    // output frames are handed off to the streams without copying
+    BufferPool<std::complex<float> > fftPool;
+    BufferPool<float> psdPool;
 
+    // consecutive frames going out in one packet
+    FrameAggregator<std::complex<float> > fftFrames;
+    FrameAggregator<float> psdFrames;
+
+    // fft as 16-bit block floating point: each frame starts with an extra
+    // element holding its exponent
+    BufferPool<short> fftShortPool;
+    FrameAggregator<short> fftShortFrames;
+
+    // change-only psd output, when enabled
+    ChangeFilter psdChanges;
+
+    bulkio::OutFloatStream outFFT;
+    bulkio::OutFloatStream outPSD;
+    bulkio::OutShortStream outFFTShort;
+    BULKIO::StreamSRI psdSRI;
+};
+
+class CrossSpectralProcessor;
 
 typedef struct ParamStruct {
     size_t fftSz;
@@ -31,12 +110,46 @@ typedef struct ParamStruct {
     size_t strideSize;
     size_t numAverage;
     bool numAverageChanged;
+    double maxOutputRate;
     int overlap;
     bool doFFT;
+    bool doFFTShort;
     bool doPSD;
+    bool doOccupancy;
+    bool doPeaks;
+    bool doAcf;
+    bool doBands;
     bool rfFreqUnits;
     float logCoeff;
+    PsdEngine::AverageMode averageMode;
+    double percentile;
+    size_t tapers;
+    double bandwidth;
+    bool packedReal;
+    boost::shared_ptr<FrameBatcherPool> batching;
+    boost::shared_ptr<CrossSpectralProcessor> crossSpectral;
+    size_t framesPerPacket;
+    double maxLatency;
+    float occupancyThreshold;
+    double occupancyInterval;
+    size_t peakCount;
+    bool peakInterpolation;
+    float changeThreshold;
+    double changeKeepAlive;
+    bool acfEnabled;
+    bool acfZeroPad;
+    std::vector<band_struct> bands;
     bool updateSRI;
+    std::string historyDir;
+    size_t historyBytes;
+    bool historyChanged;
+    std::vector<boost::shared_ptr<PsdResolution> > resolutions;
+    bool resolutionsChanged;
+    std::vector<double> sparseFrequencies;
+    std::vector<unsigned int> sparseBins;
+    ThreadPlacement placement;
+    bool placementChanged;
+    bool reallocate;
 } param_struct;
 
 
@@ -51,42 +164,109 @@ class PsdProcessor : protected ThreadedComponent
     //this class does both fft,psd, or both (or neither) as requested at processing time
 public:
     PsdProcessor(bulkio::InFloatStream inStream, bulkio::OutFloatStream fftStream, bulkio::OutFloatStream psdStream,
-            size_t fftSize, int overlap, size_t numAvg,    float logCoeff,    bool doFFT,    bool doPSD,    bool rfFreqUnits, float delay=0.1);
+            bulkio::OutFloatStream occupancyStream, bulkio::OutDoubleStream peakStream,
+            bulkio::OutFloatStream acfStream, bulkio::OutFloatStream bandStream,
+            bulkio::OutShortStream fftShortStream, size_t fftSize, int overlap, size_t numAvg,    float logCoeff,    bool doFFT,    bool doPSD,    bool rfFreqUnits, float delay=0.1);
     ~PsdProcessor();
 
+    // starts the processing thread; the update calls made before this
+    // apply from the first block
+    void start();
     void updateFftSize(size_t fftSize);
     void updateOverlap(int overlap);
     void updateNumAvg(size_t avg);
+    void updateMaxOutputRate(double rate);
+    void updateAveraging(PsdEngine::AverageMode mode, double percentile);
+    void updateMultitaper(size_t tapers, double bandwidth);
     void updateRfFreqUnits(bool enable);
+    void updatePackedReal(bool enable);
+    void updateBatching(const boost::shared_ptr<FrameBatcherPool>& batching);
+    void updateCrossSpectral(const boost::shared_ptr<CrossSpectralProcessor>& crossSpectral);
+    void updateAggregation(size_t framesPerPacket, double maxLatency);
+    void updateOccupancy(float threshold, double interval);
+    void updatePeaks(size_t count, bool interpolate);
+    void updateChangeOnly(float threshold, double keepAlive);
+    void updateAutocorrelation(bool enable, bool zeroPad);
+    void updateBands(const std::vector<band_struct>& bands);
     void updateLogCoefficient(float logCoeff);
-    void updateActions(bool psd, bool fft);
+    void updateActions(bool psd, bool fft, bool fftShort, bool occupancy, bool peaks, bool acf, bool bands);
+    void updateHistory(const std::string& directory, size_t maxBytes);
+    void updateResolutions(const std::vector<boost::shared_ptr<PsdResolution> >& resolutions);
+    void updateSparse(const std::vector<double>& frequencies, const std::vector<unsigned int>& bins);
+    void updatePlacement(const ThreadPlacement& placement);
+    void reallocate();
     void forceSRIUpdate();
+    boost::shared_ptr<WaterfallHistory> history();
+    // psd frames held back by the change-only output so far
+    uint64_t suppressedFrames();
     bool finished();
     void stop() throw (CF::Resource::StopError, CORBA::SystemException);
 
 private:
     int serviceFunction();
     void updateSRI(const bulkio::FloatDataBlock &block);
+    void updateSRI(const bulkio::FloatDataBlock &block, PsdResolution& resolution);
+    void updateOccupancySRI(const bulkio::FloatDataBlock &block);
+    void writeOccupancy(PsdResolution& resolution);
+    void updatePeakSRI();
+    void writePeaks(const float* psd, size_t bins, const BULKIO::PrecisionUTCTime& time);
+    void updateAutocorrelationSRI(const bulkio::FloatDataBlock &block);
+    void writeAutocorrelation(const float* psd, float logCoeff, size_t fftSize, size_t frameLength,
+                              const BULKIO::PrecisionUTCTime& time);
+    void updateBandSRI();
+    void writeBands(const float* psd, const BULKIO::PrecisionUTCTime& time);
+    double outputStart(const BULKIO::StreamSRI& sri, const PsdFrequencyAxis& axis);
+    std::vector<double> sparsePositions(const PsdFrequencyAxis& axis, double xstart,
+                                        CORBA::DoubleSeq& frequencies);
+    float occupancyThreshold() const;
+    PsdEngineSettings engineSettings(size_t fftSize);
+    void processFrames(PsdResolution& resolution, bool final, bool doHistory);
+    size_t transformBatch(PsdResolution& resolution, bool final, FrameBatcher& batcher);
     void flush();
 
-    // in/out streams
+    // input stream and the samples shared by all resolutions
     bulkio::InFloatStream in;
-    bulkio::OutFloatStream outFFT;
-    bulkio::OutFloatStream outPSD;
+    SampleBuffer input_;
+
+    // the resolution configured by fftSize/overlap/numAvg is always first,
+    // followed by any additional ones
+    std::vector<boost::shared_ptr<PsdResolution> > resolutions_;
+
+    // replacement engine for the primary resolution after an fft size change
+    PsdEngineBuilder builder_;
+
+    // waterfall history of the (primary) psd output
+    boost::shared_ptr<WaterfallHistory> history_;
+
+    // occupancy of the primary resolution: a summary frame is written every
+    // occupancyFrames_ frames, with the time of the first one
+    bulkio::OutFloatStream outOccupancy_;
+    size_t occupancyFrames_;
+    BULKIO::PrecisionUTCTime occupancyStart_;
 
-    // PSD processing object ptrs
-    RealPsd* realPsd_;
-    ComplexPsd* complexPsd_;
+    // strongest peaks of each primary psd frame, with their frequencies on
+    // the psd output axis; peakCount_ is 0 when disabled
+    bulkio::OutDoubleStream outPeaks_;
+    PeakFinder peakFinder_;
+    size_t peakCount_;
+    double peakXstart_;
+    double peakXdelta_;
 
-    //internal processing vectors
-    RealFFTWVector realIn_;
-    ComplexFFTWVector complexIn_;
-    ComplexFFTWVector fftOut_;
-    RealFFTWVector psdOut_;
+    // autocorrelation of the primary resolution, from its psd or, when
+    // zero padded, from a psd of frames padded to twice the fft size
+    bulkio::OutFloatStream outAcf_;
+    bool acfActive_;
+    boost::scoped_ptr<PsdEngine> acfEngine_;
+    Autocorrelation acf_;
+    BufferPool<float> acfPool_;
 
-    // for psd averaging
-    VectorMean<float, fftwf_allocator<float> > vecMean_;
-    std::vector<float> psdAverage_;
+    // power in each configured band of the primary psd frames
+    bulkio::OutFloatStream outBands_;
+    bool bandsActive_;
+    BandPower bandPower_;
+
+    // psd frames held back by the change-only output, guarded by paramLock
+    uint64_t suppressed_;
 
     // parameters and status
     bool eos;
@@ -95,6 +275,72 @@ private:
     boost::shared_ptr<boost::mutex> paramLock;
 };
 
+class CrossSpectralProcessor : protected ThreadedComponent
+{
+    ENABLE_LOGGING
+    //computes the cross-spectral density and coherence between a group of
+    //input streams.  each member is still read (and processed on its own)
+    //by its PsdProcessor, which passes the blocks it reads on here
+    //
+    //processing starts once every member has data.  the members are aligned
+    //on their time stamps and framed in lockstep.  each pair of streams is
+    //output on stream "<first>_x_<second>" of the csd and coherence ports.
+    //the group finishes once every member has ended
+public:
+    CrossSpectralProcessor(const std::vector<std::string>& streamIDs,
+            bulkio::OutFloatPort* csdPort, bulkio::OutFloatPort* coherencePort,
+            size_t fftSize, int overlap, size_t numAvg, float delay=0.1);
+    ~CrossSpectralProcessor();
+
+    // a block read from a member stream; other streams are ignored
+    void push(const std::string& streamID, const bulkio::FloatDataBlock& block);
+    void endOfStream(const std::string& streamID);
+    void updateFraming(size_t fftSize, int overlap, size_t numAvg);
+    bool finished();
+    void stop() throw (CF::Resource::StopError, CORBA::SystemException);
+
+private:
+    struct Channel {
+        // blocks pushed since the last pass and end of stream, guarded by
+        // lock_
+        std::deque<bulkio::FloatDataBlock> blocks;
+        bool ended;
+        SampleBuffer input;
+        double xdelta;
+        uint64_t next;
+    };
+
+    // while a member is stalled (or has ended) the others are buffered up
+    // to this many frames; beyond that their oldest samples are dropped and
+    // the group is realigned once every member has data again
+    static const size_t MAX_BUFFERED_FRAMES = 64;
+
+    int serviceFunction();
+    void align();
+    void limitBuffering();
+    void updateSRI(const BULKIO::StreamSRI &inputSRI);
+    void flush();
+
+    std::vector<std::string> streamIDs_;
+    std::vector<Channel> channels_;
+    std::vector<bulkio::OutFloatStream> outCSD_;
+    std::vector<bulkio::OutFloatStream> outCoherence_;
+
+    CrossSpectralEngine engine_;
+    size_t fftSz_;
+    size_t strideSize_;
+    size_t numAverage_;
+    bool framingChanged_;
+    bool aligned_;
+    bool dropping_;
+    // SRI of the first member, which the outputs are described by
+    BULKIO::StreamSRI sri_;
+    bool haveSRI_;
+
+    bool eos;
+    boost::mutex lock_;
+};
+
 class psd_i : public psd_base
 {
     ENABLE_LOGGING
@@ -108,17 +354,93 @@ class psd_i : public psd_base
     private:
         void fftSizeChanged(unsigned int oldValue, unsigned int newValue);
         void numAvgChanged(unsigned int oldValue, unsigned int newValue);
+        void maxOutputRateChanged(double oldValue, double newValue);
+        void averagingChanged(const std::string& oldValue, const std::string& newValue);
+        void averagingPercentileChanged(double oldValue, double newValue);
+        PsdEngine::AverageMode averageMode(double& percentile) const;
+        void multitaperChanged(unsigned int oldValue, unsigned int newValue);
+        void multitaperBandwidthChanged(double oldValue, double newValue);
+        void updateMultitaper();
         void overlapChanged(int oldValue, int newValue);
         void rfFreqUnitsChanged(bool oldValue, bool newValue);
+        void packedRealFftChanged(bool oldValue, bool newValue);
+        void outputAggregationChanged(unsigned int oldValue, unsigned int newValue);
+        void outputMaxLatencyChanged(double oldValue, double newValue);
+        void occupancyThresholdChanged(float oldValue, float newValue);
+        void occupancyIntervalChanged(double oldValue, double newValue);
+        void peakCountChanged(unsigned int oldValue, unsigned int newValue);
+        void peakInterpolationChanged(bool oldValue, bool newValue);
+        void changeThresholdChanged(float oldValue, float newValue);
+        void changeKeepAliveChanged(double oldValue, double newValue);
+        void autocorrelationChanged(bool oldValue, bool newValue);
+        void bandsChanged(const std::vector<band_struct>& oldValue, const std::vector<band_struct>& newValue);
+        CORBA::ULongLong getSuppressedFrames();
+        void batchSizeChanged(unsigned int oldValue, unsigned int newValue);
+        void batchMaxDelayChanged(double oldValue, double newValue);
+        void updateBatching();
         void logCoeffChanged(float oldValue, float newValue);
+        void historyDirectoryChanged(const std::string& oldValue, const std::string& newValue);
+        void historySizeChanged(unsigned int oldValue, unsigned int newValue);
+        void historyReplayChanged(const historyReplay_struct& oldValue, const historyReplay_struct& newValue);
+        void sparseFrequenciesChanged(const std::vector<double>& oldValue, const std::vector<double>& newValue);
+        void sparseBinsChanged(const std::vector<CORBA::ULong>& oldValue, const std::vector<CORBA::ULong>& newValue);
+        void cpuAffinityChanged(const std::string& oldValue, const std::string& newValue);
+        void affinityModeChanged(const std::string& oldValue, const std::string& newValue);
+        void numaLocalChanged(bool oldValue, bool newValue);
+        void realtimePriorityChanged(unsigned short oldValue, unsigned short newValue);
+        void prewarm();
+        bool getWarmupComplete();
+        void hugePagesChanged(const std::string& oldValue, const std::string& newValue);
+        std::string getHugePageBacking();
+        ThreadPlacement placement(size_t index) const;
+        void updatePlacements();
+        void resolutionsChanged(const std::vector<resolution_struct>& oldValue, const std::vector<resolution_struct>& newValue);
+        std::vector<boost::shared_ptr<PsdResolution> > createResolutions(const std::string& streamID);
+        void replayHistory(historyReplay_struct request, std::string directory);
+        bool replayCancelled();
+        void stopReplays();
+        size_t historyBytes() const;
         void clearThreads();
+        void attachCrossSpectral();
 
         typedef std::map<std::string, boost::shared_ptr<PsdProcessor> > map_type;
         map_type stateMap;
         boost::mutex stateMapLock;
 
+        // suppressed frames of the streams that have ended
+        uint64_t finishedSuppressed;
+
+        // background planning of the configured sizes, so that new streams
+        // start without waiting on fftw; one per size and input type
+        typedef std::map<std::pair<size_t, bool>, boost::shared_ptr<PsdEngineBuilder> > warmup_map;
+        warmup_map warmup_;
+        // input types of the streams seen so far, which are the ones warmed
+        // (both until the first stream)
+        bool realInput_;
+        bool complexInput_;
+        boost::mutex warmupLock;
+
+        // batched transforms shared by all streams; NULL if batching is off
+        boost::shared_ptr<FrameBatcherPool> batching_;
+
+        // number of processors placed so far, for round-robin cpu assignment
+        size_t placementCount;
+
+        // history replays and exports in progress, each on its own thread
+        std::vector<boost::shared_ptr<boost::thread> > replays_;
+        bool replayCancel;
+        boost::mutex replayLock;
+
+        // group of streams processed for cross-spectral density
+        boost::shared_ptr<CrossSpectralProcessor> crossSpectral;
+
         bool doPSD;
         bool doFFT;
+        bool doFFTShort;
+        bool doOccupancy;
+        bool doPeaks;
+        bool doAcf;
+        bool doBands;
 
         bulkio::MemberConnectionEventListener<psd_i> listener;
         void callBackFunc( const char* connectionId);
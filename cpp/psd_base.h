@@ -6,6 +6,7 @@
 #include <ossie/ThreadedComponent.h>
 
 #include <bulkio/bulkio.h>
+#include "struct_props.h"
 
 class psd_base : public Component, protected ThreadedComponent
 {
@@ -29,10 +30,78 @@ class psd_base : public Component, protected ThreadedComponent
         CORBA::Long overlap;
         /// Property: numAvg
         CORBA::ULong numAvg;
+        /// Property: maxOutputRate
+        double maxOutputRate;
+        /// Property: averaging
+        std::string averaging;
+        /// Property: averagingPercentile
+        double averagingPercentile;
+        /// Property: multitaperTapers
+        CORBA::ULong multitaperTapers;
+        /// Property: multitaperBandwidth
+        double multitaperBandwidth;
         /// Property: logCoefficient
         float logCoefficient;
         /// Property: rfFreqUnits
         bool rfFreqUnits;
+        /// Property: historyDirectory
+        std::string historyDirectory;
+        /// Property: historySize
+        CORBA::ULong historySize;
+        /// Property: historyReplay
+        historyReplay_struct historyReplay;
+        /// Property: resolutions
+        std::vector<resolution_struct> resolutions;
+        /// Property: crossSpectralStreams
+        std::vector<std::string> crossSpectralStreams;
+        /// Property: sparseFrequencies
+        std::vector<double> sparseFrequencies;
+        /// Property: sparseBins
+        std::vector<CORBA::ULong> sparseBins;
+        /// Property: packedRealFft
+        bool packedRealFft;
+        /// Property: outputAggregation
+        CORBA::ULong outputAggregation;
+        /// Property: outputMaxLatency
+        double outputMaxLatency;
+        /// Property: occupancyThreshold
+        float occupancyThreshold;
+        /// Property: occupancyInterval
+        double occupancyInterval;
+        /// Property: peakCount
+        CORBA::ULong peakCount;
+        /// Property: peakInterpolation
+        bool peakInterpolation;
+        /// Property: changeThreshold
+        float changeThreshold;
+        /// Property: changeKeepAlive
+        double changeKeepAlive;
+        /// Property: suppressedFrames
+        CORBA::ULongLong suppressedFrames;
+        /// Property: autocorrelation
+        bool autocorrelation;
+        /// Property: autocorrelationZeroPad
+        bool autocorrelationZeroPad;
+        /// Property: bands
+        std::vector<band_struct> bands;
+        /// Property: batchSize
+        CORBA::ULong batchSize;
+        /// Property: batchMaxDelay
+        double batchMaxDelay;
+        /// Property: warmupComplete
+        bool warmupComplete;
+        /// Property: hugePages
+        std::string hugePages;
+        /// Property: hugePageBacking
+        std::string hugePageBacking;
+        /// Property: cpuAffinity
+        std::string cpuAffinity;
+        /// Property: affinityMode
+        std::string affinityMode;
+        /// Property: numaLocal
+        bool numaLocal;
+        /// Property: realtimePriority
+        unsigned short realtimePriority;
 
         // Ports
         /// Port: dataFloat_in
@@ -45,6 +114,20 @@ class psd_base : public Component, protected ThreadedComponent
         bulkio::OutFloatPort *fft_dataFloat_out;
         /// Port: psd_dataShort_out
         bulkio::OutShortPort *psd_dataShort_out;
+        /// Port: csd_dataFloat_out
+        bulkio::OutFloatPort *csd_dataFloat_out;
+        /// Port: coherence_dataFloat_out
+        bulkio::OutFloatPort *coherence_dataFloat_out;
+        /// Port: occupancy_dataFloat_out
+        bulkio::OutFloatPort *occupancy_dataFloat_out;
+        /// Port: peaks_dataDouble_out
+        bulkio::OutDoublePort *peaks_dataDouble_out;
+        /// Port: acf_dataFloat_out
+        bulkio::OutFloatPort *acf_dataFloat_out;
+        /// Port: bands_dataFloat_out
+        bulkio::OutFloatPort *bands_dataFloat_out;
+        /// Port: fft_dataShort_out
+        bulkio::OutShortPort *fft_dataShort_out;
 
     private:
 };
@@ -0,0 +1,539 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+/**************************************************************************
+
+    Offline driver for the psd processing path.
+
+    Memory-maps recorded raw or BLUE files and runs the same framing, fft,
+    averaging and log processing as the component, without an ORB, as fast
+    as the available cores allow.  Each input produces a BLUE type 2000 file
+    of psd frames.
+
+    Files are split into segments on averaging boundaries so that a single
+    large file is also processed in parallel.  Every frame is transformed
+    with a full fft, on its own or, with packed real transforms, paired with
+    its even/odd neighbour, so the output does not depend on how the file
+    is split or on the number of jobs.  (Separate runs can still differ in the last
+    bits if fftw measures a different algorithm for its plan.)
+
+**************************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "bluefile.h"
+#include "huge_pages.h"
+#include "psd_engine.h"
+
+namespace {
+
+struct BatchOptions {
+    BatchOptions() :
+        fftSize(32768),
+        overlap(0),
+        numAvg(0),
+        logCoeff(0),
+        sampleRate(1.0),
+        jobs(boost::thread::hardware_concurrency()),
+        hugePages(hugepages::MODE_OFF),
+        packedReal(false),
+        percentile(-1),
+        tapers(0),
+        bandwidth(4.0)
+    {
+        format[0] = 'S';
+        format[1] = 'F';
+        if (jobs == 0)
+            jobs = 1;
+    }
+
+    size_t fftSize;
+    long overlap;
+    size_t numAvg;
+    float logCoeff;
+    char format[2];
+    double sampleRate;
+    size_t jobs;
+    std::string outputDir;
+    hugepages::Mode hugePages;
+    bool packedReal;
+    double percentile;  // negative for the mean
+    size_t tapers;
+    double bandwidth;
+};
+
+struct InputFile {
+    InputFile() : fd(-1), map(NULL), mapSize(0), data(NULL), samples(0), complex(false),
+                  scalar('F'), swapped(false), xdelta(1.0), timecode(0), frames(0),
+                  outFrames(0), outFd(-1), failed(false) {}
+
+    std::string path;
+    std::string output;
+    int fd;
+    unsigned char* map;
+    size_t mapSize;
+    const unsigned char* data;
+    size_t samples;     // complex samples for complex data
+    bool complex;
+    char scalar;        // 'F' (float32) or 'I' (int16)
+    bool swapped;
+    double xdelta;
+    double timecode;
+    size_t frames;
+    size_t outFrames;
+    int outFd;
+    bool failed;
+};
+
+struct WorkItem {
+    InputFile* file;
+    size_t firstFrame;
+    size_t lastFrame;
+};
+
+class WorkQueue {
+public:
+    WorkQueue(std::vector<WorkItem>& items) : items_(items), next_(0) {}
+
+    WorkItem* pop() {
+        boost::mutex::scoped_lock lock(lock_);
+        if (next_ >= items_.size())
+            return NULL;
+        return &items_[next_++];
+    }
+
+    // backing of the processing buffers, as seen by the first segment
+    void setBacking(const std::string& backing) {
+        boost::mutex::scoped_lock lock(lock_);
+        if (backing_.empty())
+            backing_ = backing;
+    }
+    const std::string& backing() const { return backing_; }
+
+private:
+    std::vector<WorkItem>& items_;
+    size_t next_;
+    boost::mutex lock_;
+    std::string backing_;
+};
+
+void usage(const char* name) {
+    std::cerr << "Usage: " << name << " [options] FILE..." << std::endl
+              << std::endl
+              << "Compute psd frames for recorded raw or BLUE files." << std::endl
+              << std::endl
+              << "  -n, --fftSize N          fft size (default 32768)" << std::endl
+              << "  -o, --overlap N          input samples to overlap; negative skips samples (default 0)" << std::endl
+              << "  -a, --numAvg N           frames to average per psd output (default 0)" << std::endl
+              << "  -l, --logCoefficient X   if > 0, output X*log10(psd) (default 0)" << std::endl
+              << "  -p, --percentile P       average with the P-th percentile of each bin (50 for the median) instead of the mean" << std::endl
+              << "  -t, --tapers K           multitaper psd with K DPSS tapers (default 0: no taper)" << std::endl
+              << "  -w, --bandwidth NW       time-bandwidth product of the tapers (default 4)" << std::endl
+              << "  -f, --format FMT         format of raw files: SF, CF, SI or CI (default SF)" << std::endl
+              << "  -r, --sampleRate HZ      sample rate of raw files (default 1.0)" << std::endl
+              << "  -j, --jobs N             worker threads (default: number of cores)" << std::endl
+              << "  -d, --outputDir DIR      directory for output files (default: next to input)" << std::endl
+              << "  -P, --packedReal         transform pairs of real frames with one complex fft" << std::endl
+              << "  -H, --hugePages MODE     back large buffers with huge pages: off, transparent or explicit (default off)" << std::endl
+              << "  -h, --help               show this message" << std::endl
+              << std::endl
+              << "Output files are named <input>.psd and are BLUE type 2000 (SF)." << std::endl;
+}
+
+double now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec*1e-6;
+}
+
+std::string outputPath(const std::string& input, const std::string& outputDir) {
+    std::string base = input;
+    if (!outputDir.empty()) {
+        std::string::size_type slash = input.rfind('/');
+        if (slash != std::string::npos)
+            base = input.substr(slash+1);
+        base = outputDir + "/" + base;
+    }
+    return base + ".psd";
+}
+
+bool openInput(InputFile& file, const BatchOptions& options) {
+    file.fd = open(file.path.c_str(), O_RDONLY);
+    struct stat st;
+    if (file.fd < 0 || fstat(file.fd, &st) != 0) {
+        std::cerr << file.path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    file.mapSize = st.st_size;
+    if (file.mapSize == 0) {
+        std::cerr << file.path << ": empty file" << std::endl;
+        return false;
+    }
+    void* map = mmap(NULL, file.mapSize, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << file.path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    file.map = static_cast<unsigned char*>(map);
+    madvise(file.map, file.mapSize, MADV_SEQUENTIAL);
+
+    size_t dataStart = 0;
+    size_t dataBytes = file.mapSize;
+    char format[2] = { options.format[0], options.format[1] };
+    file.xdelta = 1.0/options.sampleRate;
+
+    BlueHeader header;
+    if (file.mapSize >= BLUE_HCB_SIZE && parseBlueHeader(file.map, header)) {
+        if (header.type/1000 != 1) {
+            std::cerr << file.path << ": unsupported BLUE type " << header.type << std::endl;
+            return false;
+        }
+        dataStart = size_t(header.dataStart);
+        dataBytes = std::min(size_t(header.dataSize), file.mapSize - std::min(dataStart, file.mapSize));
+        format[0] = header.format[0];
+        format[1] = header.format[1];
+        file.xdelta = header.xdelta;
+        file.timecode = header.timecode;
+        file.swapped = header.dataSwapped;
+    }
+
+    if ((format[0] != 'S' && format[0] != 'C') || (format[1] != 'F' && format[1] != 'I')) {
+        std::cerr << file.path << ": unsupported format " << format[0] << format[1] << std::endl;
+        return false;
+    }
+    file.complex = (format[0] == 'C');
+    file.scalar = format[1];
+
+    size_t sampleBytes = (file.scalar == 'F' ? sizeof(float) : sizeof(int16_t)) * (file.complex ? 2 : 1);
+    file.data = file.map + dataStart;
+    file.samples = dataBytes / sampleBytes;
+
+    // framing matches the component: full frames every stride samples, then
+    // one zero-padded partial frame if input remains
+    size_t stride = options.fftSize - options.overlap;
+    if (file.samples >= options.fftSize)
+        file.frames = (file.samples - options.fftSize)/stride + 1;
+    if (file.frames*stride < file.samples)
+        file.frames++;
+
+    size_t avg = options.numAvg > 1 ? options.numAvg : 1;
+    file.outFrames = file.frames / avg;
+    return true;
+}
+
+bool openOutput(InputFile& file, const BatchOptions& options) {
+    PsdFrequencyAxis axis(file.xdelta, options.fftSize, file.complex);
+    size_t avg = options.numAvg > 1 ? options.numAvg : 1;
+
+    BlueHeader header;
+    header.type = 2000;
+    header.format[0] = 'S';
+    header.format[1] = 'F';
+    header.dataSize = double(file.outFrames)*axis.bins*sizeof(float);
+    header.timecode = file.timecode;
+    header.xstart = axis.xstart;
+    header.xdelta = axis.xdelta;
+    header.xunits = 3; // frequency
+    header.subsize = axis.bins;
+    header.ystart = 0;
+    header.ydelta = file.xdelta*(options.fftSize - options.overlap)*avg;
+    header.yunits = 1; // time
+
+    FILE* fp = fopen(file.output.c_str(), "wb");
+    if (!fp || !writeBlueHeader(fp, header)) {
+        std::cerr << file.output << ": " << strerror(errno) << std::endl;
+        if (fp)
+            fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    // frames are written in place by the workers, possibly out of order
+    file.outFd = open(file.output.c_str(), O_WRONLY);
+    if (file.outFd < 0 || ftruncate(file.outFd, BLUE_HCB_SIZE + size_t(header.dataSize)) != 0) {
+        std::cerr << file.output << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void closeFile(InputFile& file) {
+    if (file.map)
+        munmap(file.map, file.mapSize);
+    if (file.fd >= 0)
+        close(file.fd);
+    if (file.outFd >= 0)
+        close(file.outFd);
+    file.map = NULL;
+    file.fd = file.outFd = -1;
+}
+
+template <typename T>
+T swapBytes(T value) {
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(&value);
+    std::reverse(bytes, bytes+sizeof(T));
+    return value;
+}
+
+// returns a pointer to frame data as native floats, converting into scratch
+// when the input is not already native float
+const float* frameData(const InputFile& file, size_t offset, size_t samples, std::vector<float>& scratch) {
+    size_t scalars = samples * (file.complex ? 2 : 1);
+    size_t first = offset * (file.complex ? 2 : 1);
+    if (file.scalar == 'F') {
+        const float* in = reinterpret_cast<const float*>(file.data) + first;
+        if (!file.swapped)
+            return in;
+        scratch.resize(scalars);
+        for (size_t i=0; i<scalars; i++)
+            scratch[i] = swapBytes(in[i]);
+    } else {
+        const int16_t* in = reinterpret_cast<const int16_t*>(file.data) + first;
+        scratch.resize(scalars);
+        if (file.swapped) {
+            for (size_t i=0; i<scalars; i++)
+                scratch[i] = swapBytes(in[i]);
+        } else {
+            for (size_t i=0; i<scalars; i++)
+                scratch[i] = in[i];
+        }
+    }
+    return &scratch[0];
+}
+
+void processItem(const WorkItem& item, const BatchOptions& options, WorkQueue& queue) {
+    InputFile& file = *item.file;
+    PsdEngine engine(options.fftSize, options.numAvg, options.logCoeff);
+    std::vector<float> scratch;
+
+    size_t stride = options.fftSize - options.overlap;
+    size_t avg = options.numAvg > 1 ? options.numAvg : 1;
+    // no sliding dft: it carries rounding from frame to frame, and whether
+    // it is used is decided by timing, so the output would depend on where
+    // each segment starts and on the load at the time
+    engine.setStride(0);
+    engine.setPackedReal(options.packedReal);
+    engine.setMultitaper(options.tapers, options.bandwidth);
+    if (options.percentile >= 0)
+        engine.setAveraging(PsdEngine::AVERAGE_PERCENTILE, options.percentile);
+    std::vector<float> followingScratch;
+
+    for (size_t frame=item.firstFrame; frame<item.lastFrame; frame++) {
+        size_t offset = frame*stride;
+        size_t samples = std::min(options.fftSize, file.samples - offset);
+        const float* data = frameData(file, offset, samples, scratch);
+
+        // the next frame of the segment, to be transformed with this one;
+        // segments start on even frames, so pairs are always 2k and 2k+1
+        const float* following = NULL;
+        if (options.packedReal && !file.complex && frame+1 < item.lastFrame &&
+            offset+stride+options.fftSize <= file.samples) {
+            following = frameData(file, offset+stride, options.fftSize, followingScratch);
+        }
+        if (!engine.process(data, samples, file.complex, true, NULL, NULL, following))
+            continue;
+
+        // segments start on averaging boundaries, so the output index
+        // follows directly from the frame index
+        size_t outFrame = (frame+1)/avg - 1;
+        size_t bytes = engine.psdLength()*sizeof(float);
+        off_t pos = BLUE_HCB_SIZE + off_t(outFrame)*bytes;
+        if (pwrite(file.outFd, engine.psd(), bytes, pos) != ssize_t(bytes)) {
+            std::cerr << file.output << ": " << strerror(errno) << std::endl;
+            file.failed = true;
+            return;
+        }
+        if (outFrame == 0)
+            queue.setBacking(hugepages::backing());
+    }
+}
+
+void worker(WorkQueue* queue, const BatchOptions* options) {
+    while (WorkItem* item = queue->pop())
+        processItem(*item, *options, *queue);
+}
+
+bool parseSize(const char* arg, size_t& value) {
+    char* end;
+    long parsed = strtol(arg, &end, 0);
+    if (*end != '\0' || parsed < 0)
+        return false;
+    value = parsed;
+    return true;
+}
+
+bool parseOverlap(const char* arg, long& value) {
+    // checked against fftSize once all options are in
+    char* end;
+    errno = 0;
+    long parsed = strtol(arg, &end, 0);
+    if (end == arg || *end != '\0' || errno != 0)
+        return false;
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BatchOptions options;
+
+    static struct option longOptions[] = {
+        {"fftSize",        required_argument, 0, 'n'},
+        {"overlap",        required_argument, 0, 'o'},
+        {"numAvg",         required_argument, 0, 'a'},
+        {"logCoefficient", required_argument, 0, 'l'},
+        {"percentile",     required_argument, 0, 'p'},
+        {"tapers",         required_argument, 0, 't'},
+        {"bandwidth",      required_argument, 0, 'w'},
+        {"format",         required_argument, 0, 'f'},
+        {"sampleRate",     required_argument, 0, 'r'},
+        {"jobs",           required_argument, 0, 'j'},
+        {"outputDir",      required_argument, 0, 'd'},
+        {"packedReal",     no_argument,       0, 'P'},
+        {"hugePages",      required_argument, 0, 'H'},
+        {"help",           no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:o:a:l:p:t:w:f:r:j:d:PH:h", longOptions, NULL)) != -1) {
+        bool ok = true;
+        switch (opt) {
+            case 'n': ok = parseSize(optarg, options.fftSize) && options.fftSize > 0; break;
+            case 'o': ok = parseOverlap(optarg, options.overlap); break;
+            case 'a': ok = parseSize(optarg, options.numAvg); break;
+            case 'l': options.logCoeff = atof(optarg); break;
+            case 'p':
+                options.percentile = atof(optarg);
+                ok = options.percentile >= 0 && options.percentile <= 100;
+                break;
+            case 't': ok = parseSize(optarg, options.tapers); break;
+            case 'w': options.bandwidth = atof(optarg); ok = options.bandwidth > 0; break;
+            case 'f':
+                ok = strlen(optarg) == 2;
+                if (ok) {
+                    options.format[0] = toupper(optarg[0]);
+                    options.format[1] = toupper(optarg[1]);
+                }
+                break;
+            case 'r': options.sampleRate = atof(optarg); ok = options.sampleRate > 0; break;
+            case 'j': ok = parseSize(optarg, options.jobs) && options.jobs > 0; break;
+            case 'd': options.outputDir = optarg; break;
+            case 'P': options.packedReal = true; break;
+            case 'H': ok = hugepages::parseMode(optarg, options.hugePages); break;
+            case 'h': usage(argv[0]); return 0;
+            default: usage(argv[0]); return 1;
+        }
+        if (!ok) {
+            std::cerr << "Invalid value for -" << char(opt) << ": " << optarg << std::endl;
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (options.overlap >= long(options.fftSize)) {
+        std::cerr << "overlap must be less than fftSize" << std::endl;
+        return 1;
+    }
+    hugepages::setMode(options.hugePages);
+
+    std::vector<InputFile> files(argc - optind);
+    size_t totalFrames = 0;
+    for (size_t i=0; i<files.size(); i++) {
+        files[i].path = argv[optind+i];
+        files[i].output = outputPath(files[i].path, options.outputDir);
+        if (!openInput(files[i], options) || !openOutput(files[i], options)) {
+            files[i].failed = true;
+            continue;
+        }
+        totalFrames += files[i].frames;
+    }
+
+    // split the work into roughly jobs*4 segments, each a multiple of the
+    // averaging length, so that all cores stay busy even with one file;
+    // packed real transforms pair frame 2k with 2k+1, so segments then also
+    // hold a whole number of pairs and no pair is split by the job count
+    size_t avg = options.numAvg > 1 ? options.numAvg : 1;
+    if (options.packedReal && avg % 2)
+        avg *= 2;
+    size_t segment = std::max<size_t>(totalFrames / (options.jobs*4), 1);
+    segment = ((segment + avg - 1)/avg)*avg;
+
+    std::vector<WorkItem> items;
+    for (size_t i=0; i<files.size(); i++) {
+        if (files[i].failed)
+            continue;
+        for (size_t first=0; first<files[i].frames; first+=segment) {
+            WorkItem item;
+            item.file = &files[i];
+            item.firstFrame = first;
+            item.lastFrame = std::min(first+segment, files[i].frames);
+            items.push_back(item);
+        }
+    }
+
+    double start = now();
+    WorkQueue queue(items);
+    boost::thread_group workers;
+    for (size_t i=0; i<std::min(options.jobs, items.size()); i++)
+        workers.create_thread(boost::bind(&worker, &queue, &options));
+    workers.join_all();
+    double elapsed = now() - start;
+
+    int status = 0;
+    size_t totalSamples = 0;
+    for (size_t i=0; i<files.size(); i++) {
+        if (files[i].failed) {
+            status = 1;
+        } else {
+            totalSamples += files[i].samples;
+            std::cout << files[i].path << " -> " << files[i].output << " ("
+                      << files[i].outFrames << " frames)" << std::endl;
+        }
+        closeFile(files[i]);
+    }
+    if (elapsed > 0) {
+        std::cout << totalFrames << " frames, " << totalSamples << " samples in " << elapsed << " s ("
+                  << totalSamples/elapsed/1e6 << " Msamples/s)" << std::endl;
+    }
+    if (options.hugePages != hugepages::MODE_OFF && !queue.backing().empty())
+        std::cout << "processing buffers: " << queue.backing() << std::endl;
+    return status;
+}
@@ -0,0 +1,822 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "psd_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <time.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace {
+    // frames timed with each method before the sliding dft is kept or dropped
+    const size_t SLIDE_TRIALS = 8;
+
+    double monotonicTime(){
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + 1e-9*ts.tv_nsec;
+    }
+
+    inline float binPower(const std::complex<float>& value){ return std::norm(value); }
+    inline float binPower(float power){ return power; }
+}
+
+PsdFrequencyAxis::PsdFrequencyAxis(double xdelta_in, size_t fftSize, bool complex) {
+    xdelta = 1.0/(xdelta_in*fftSize);
+    if (complex) {
+        xstart = -((fftSize/2-1)*xdelta);
+        bins = fftSize;
+    } else {
+        xstart = 0;
+        bins = fftSize/2+1;
+    }
+}
+
+PsdEngine::PsdEngine(size_t fftSize, size_t numAvg, float logCoeff) :
+    fftSz_(fftSize),
+    numAvg_(numAvg),
+    logCoeff_(logCoeff),
+    plan_(NULL),
+    planComplex_(false),
+    planSize_(0),
+    useGoertzel_(false),
+    packed_(false),
+    packedPlan_(NULL),
+    packedNext_(false),
+    tapers_(0),
+    bandwidth_(4.0),
+    occupancyEnabled_(false),
+    stride_(0),
+    slideMode_(SLIDE_UNDECIDED),
+    prevValid_(false),
+    sinceSync_(0),
+    fftTime_(0),
+    slideTime_(0),
+    fftTrials_(0),
+    slideTrials_(0),
+    averageMode_(AVERAGE_MEAN),
+    percentile_(50.0),
+    avgCount_(0),
+    fftPtr_(NULL),
+    fftLen_(0),
+    psdReady_(false),
+    psdPtr_(NULL),
+    psdLen_(0)
+{
+}
+
+PsdEngine::~PsdEngine(){
+    destroyPlan();
+}
+
+boost::mutex& PsdEngine::planLock(){
+    static boost::mutex lock;
+    return lock;
+}
+
+void PsdEngine::destroyPlan(){
+    if (plan_ || packedPlan_) {
+        boost::mutex::scoped_lock lock(planLock());
+        if (plan_)
+            fftwf_destroy_plan(plan_);
+        if (packedPlan_)
+            fftwf_destroy_plan(packedPlan_);
+        plan_ = NULL;
+        packedPlan_ = NULL;
+    }
+    packedNext_ = false;
+}
+
+void PsdEngine::setFftSize(size_t fftSize){
+    // the transform is rebuilt on the next frame
+    if (fftSize != fftSz_) {
+        fftSz_ = fftSize;
+        avgCount_ = 0;
+    }
+}
+
+void PsdEngine::setNumAvg(size_t numAvg){
+    if (numAvg != numAvg_) {
+        numAvg_ = numAvg;
+        avgCount_ = 0;
+    }
+}
+
+void PsdEngine::setAveraging(AverageMode mode, double percentile){
+    if (mode != averageMode_ || percentile != percentile_) {
+        averageMode_ = mode;
+        percentile_ = percentile;
+        avgCount_ = 0;
+        if (mode == AVERAGE_PERCENTILE) {
+            psdPercentile_.configure(psdAverage_.size(), percentile);
+        } else {
+            psdPercentile_.release();
+        }
+    }
+}
+
+void PsdEngine::setStride(size_t stride){
+    if (stride != stride_) {
+        stride_ = stride;
+        // rebuilt on the next frame
+        planSize_ = 0;
+    }
+}
+
+void PsdEngine::setPackedReal(bool packed){
+    if (packed != packed_) {
+        packed_ = packed;
+        // rebuilt on the next frame
+        planSize_ = 0;
+    }
+}
+
+void PsdEngine::setMultitaper(size_t tapers, double bandwidth){
+    if (tapers != tapers_ || (tapers > 0 && bandwidth != bandwidth_)) {
+        tapers_ = tapers;
+        bandwidth_ = bandwidth;
+        // rebuilt on the next frame
+        planSize_ = 0;
+    }
+}
+
+void PsdEngine::setOccupancy(bool enable, float threshold){
+    if (!enable) {
+        occupancyEnabled_ = false;
+        occupancy_.release();
+    } else if (!occupancyEnabled_ || threshold != occupancy_.threshold()) {
+        // sized by the first frame counted
+        occupancyEnabled_ = true;
+        occupancy_.configure(0, threshold);
+    }
+}
+
+void PsdEngine::takeOccupancy(float* fraction){
+    occupancy_.result(fraction);
+    occupancy_.reset();
+}
+
+void PsdEngine::setLogCoefficient(float logCoeff){
+    logCoeff_ = logCoeff;
+}
+
+void PsdEngine::setSparseBins(const std::vector<double>& bins){
+    if (bins != sparseBins_) {
+        sparseBins_ = bins;
+        // rebuilt on the next frame
+        planSize_ = 0;
+    }
+}
+
+size_t PsdEngine::sparseCrossover() const{
+    // a Goertzel bin costs about as much per sample as each of the log2(N)
+    // butterfly stages of the fft
+    size_t crossover = 0;
+    for (size_t n=fftSz_; n>1; n>>=1)
+        crossover++;
+    return crossover;
+}
+
+void PsdEngine::apply(const PsdEngineSettings& settings){
+    setStride(settings.stride);
+    setNumAvg(settings.numAvg);
+    setLogCoefficient(settings.logCoeff);
+    setAveraging(settings.averageMode, settings.percentile);
+    setMultitaper(settings.tapers, settings.bandwidth);
+    setPackedReal(settings.packedReal);
+    setOccupancy(settings.occupancy, settings.occupancyThreshold);
+    setSparseBins(settings.sparseBins);
+}
+
+void PsdEngine::flush(){
+    avgCount_ = 0;
+    occupancy_.reset();
+    prevValid_ = false;
+    packedNext_ = false;
+    psdReady_ = false;
+}
+
+void PsdEngine::release(){
+    destroyPlan();
+    RealHugeVector().swap(realIn_);
+    ComplexHugeVector().swap(complexIn_);
+    ComplexHugeVector().swap(fftOut_);
+    RealHugeVector().swap(psdOut_);
+    RealHugeVector().swap(psdAverage_);
+    psdPercentile_.release();
+    ComplexHugeVector().swap(sparseOut_);
+    ComplexHugeVector().swap(packedFft_);
+    ComplexHugeVector().swap(packedOut_);
+    multitaper_.release();
+    RealHugeVector().swap(taperPower_);
+    std::vector<float>().swap(prevIn_);
+    planSize_ = 0;
+    prevValid_ = false;
+    avgCount_ = 0;
+    psdReady_ = false;
+}
+
+void PsdEngine::prepare(bool complex){
+    if ((!plan_ && !useGoertzel_ && !multitaper()) || complex != planComplex_ || fftSz_ != planSize_)
+        setup(complex);
+}
+
+void PsdEngine::setup(bool complex){
+    destroyPlan();
+
+    size_t bins = outputLength(complex);
+    psdOut_.resize(bins);
+    psdAverage_.resize(bins);
+    if (averageMode_ == AVERAGE_PERCENTILE)
+        psdPercentile_.configure(bins, percentile_);
+    avgCount_ = 0;
+
+    // sparse bins at integer positions can be picked out of a full fft;
+    // anything else, or few enough bins, goes through Goertzel
+    size_t fullBins = complex ? fftSz_ : fftSz_/2+1;
+    useGoertzel_ = !sparseBins_.empty() && sparseBins_.size() <= sparseCrossover();
+    gather_.clear();
+    for (size_t i=0; i<sparseBins_.size() && !useGoertzel_; i++) {
+        double position = sparseBins_[i];
+        if (position != floor(position) || position < 0 || position >= fullBins)
+            useGoertzel_ = true;
+        gather_.push_back(size_t(position));
+    }
+    fftOut_.resize(sparseBins_.empty() ? bins : fullBins);
+    sparseOut_.resize(sparseBins_.empty() ? 0 : bins);
+    if (useGoertzel_) {
+        omega_.resize(bins);
+        coeff_.resize(bins);
+        for (size_t i=0; i<bins; i++) {
+            // the frequency of an output bin, in cycles per fft
+            double k = sparseBins_[i];
+            if (complex)
+                k -= fftSz_/2;
+            omega_[i] = 2*M_PI*k/fftSz_;
+            coeff_[i] = 2*cos(omega_[i]);
+        }
+        planComplex_ = complex;
+        planSize_ = fftSz_;
+        slideMode_ = SLIDE_OFF;
+        return;
+    }
+
+    if (multitaper()) {
+        // the batched transform of the tapered copies replaces the plan
+        multitaper_.configure(fftSz_, tapers_, bandwidth_, complex);
+        taperPower_.resize(bins);
+        planComplex_ = complex;
+        planSize_ = fftSz_;
+        slideMode_ = SLIDE_OFF;
+        return;
+    }
+    multitaper_.release();
+    RealHugeVector().swap(taperPower_);
+
+    boost::mutex::scoped_lock lock(planLock());
+    if (complex) {
+        RealHugeVector().swap(realIn_);
+        complexIn_.resize(fftSz_);
+        plan_ = fftwf_plan_dft_1d(fftSz_,
+                                  reinterpret_cast<fftwf_complex*>(&complexIn_[0]),
+                                  reinterpret_cast<fftwf_complex*>(&fftOut_[0]),
+                                  FFTW_FORWARD, FFTW_MEASURE);
+    } else {
+        realIn_.resize(fftSz_);
+        plan_ = fftwf_plan_dft_r2c_1d(fftSz_, &realIn_[0],
+                                      reinterpret_cast<fftwf_complex*>(&fftOut_[0]),
+                                      FFTW_MEASURE);
+        if (packed_ && sparseBins_.empty()) {
+            complexIn_.resize(fftSz_);
+            packedFft_.resize(fftSz_);
+            packedOut_.resize(bins);
+            packedPlan_ = fftwf_plan_dft_1d(fftSz_,
+                                            reinterpret_cast<fftwf_complex*>(&complexIn_[0]),
+                                            reinterpret_cast<fftwf_complex*>(&packedFft_[0]),
+                                            FFTW_FORWARD, FFTW_MEASURE);
+        } else {
+            ComplexHugeVector().swap(complexIn_);
+            ComplexHugeVector().swap(packedFft_);
+            ComplexHugeVector().swap(packedOut_);
+        }
+    }
+    planComplex_ = complex;
+    planSize_ = fftSz_;
+    setupSlide(complex);
+}
+
+void PsdEngine::setupSlide(bool complex){
+    prevValid_ = false;
+    slideTime_ = fftTime_ = 0;
+    slideTrials_ = fftTrials_ = 0;
+
+    // the sliding dft costs O(N*stride) against O(N*log(N)) for the fft, so
+    // only large overlaps are worth trying
+    if (!sparseBins_.empty() || stride_ == 0 || stride_*4 > fftSz_) {
+        slideMode_ = SLIDE_OFF;
+        return;
+    }
+    slideMode_ = SLIDE_UNDECIDED;
+
+    size_t bins = outputLength(complex);
+    slideRe_.assign(bins, 0.0);
+    slideIm_.assign(bins, 0.0);
+    twiddleRe_.resize(bins);
+    twiddleIm_.resize(bins);
+    rotateRe_.resize(bins);
+    rotateIm_.resize(bins);
+    accRe_.resize(bins);
+    accIm_.resize(bins);
+    curRe_.resize(bins);
+    curIm_.resize(bins);
+    for (size_t i=0; i<bins; i++) {
+        // frequency of the output bin, as in goertzel()
+        double k = double(i);
+        if (complex)
+            k -= double(fftSz_/2);
+        double w = 2*M_PI*k/fftSz_;
+        twiddleRe_[i] = cos(w);
+        twiddleIm_[i] = -sin(w);
+        double r = fmod(w*stride_, 2*M_PI);
+        rotateRe_[i] = cos(r);
+        rotateIm_[i] = sin(r);
+    }
+    prevIn_.resize(complex ? 2*fftSz_ : fftSz_);
+}
+
+bool PsdEngine::canSlide(const float* data, size_t length, bool complex) const{
+    if (slideMode_ == SLIDE_OFF || !prevValid_ || length != fftSz_ || sinceSync_+stride_ > fftSz_)
+        return false;
+    // frames must actually follow on from the previous one
+    size_t width = complex ? 2 : 1;
+    return memcmp(&prevIn_[stride_*width], data, (fftSz_-stride_)*width*sizeof(float)) == 0;
+}
+
+void PsdEngine::slide(const float* data, bool complex, std::complex<float>* out){
+    // X'[k] = (X[k] + sum_m (x[N+m]-x[m]) exp(-j2pi km/N)) * exp(j2pi ks/N)
+    // the loops run across bins so that they vectorize
+    size_t bins = slideRe_.size();
+    size_t width = complex ? 2 : 1;
+    const float* added = data + (fftSz_-stride_)*width;
+    const float* removed = &prevIn_[0];
+    double* accRe = &accRe_[0];
+    double* accIm = &accIm_[0];
+    double* curRe = &curRe_[0];
+    double* curIm = &curIm_[0];
+    const double* twRe = &twiddleRe_[0];
+    const double* twIm = &twiddleIm_[0];
+    std::fill(accRe_.begin(), accRe_.end(), 0.0);
+    std::fill(accIm_.begin(), accIm_.end(), 0.0);
+    std::fill(curRe_.begin(), curRe_.end(), 1.0);
+    std::fill(curIm_.begin(), curIm_.end(), 0.0);
+    for (size_t m=0; m<stride_; m++) {
+        double dr = double(added[m*width]) - removed[m*width];
+        double di = complex ? double(added[m*width+1]) - removed[m*width+1] : 0.0;
+        for (size_t k=0; k<bins; k++) {
+            accRe[k] += dr*curRe[k] - di*curIm[k];
+            accIm[k] += dr*curIm[k] + di*curRe[k];
+            double re = curRe[k]*twRe[k] - curIm[k]*twIm[k];
+            curIm[k] = curRe[k]*twIm[k] + curIm[k]*twRe[k];
+            curRe[k] = re;
+        }
+    }
+    for (size_t k=0; k<bins; k++) {
+        double re = slideRe_[k] + accRe[k];
+        double im = slideIm_[k] + accIm[k];
+        slideRe_[k] = re*rotateRe_[k] - im*rotateIm_[k];
+        slideIm_[k] = re*rotateIm_[k] + im*rotateRe_[k];
+        out[k] = std::complex<float>(slideRe_[k], slideIm_[k]);
+    }
+    sinceSync_ += stride_;
+}
+
+void PsdEngine::syncSlide(const std::complex<float>* fft){
+    size_t bins = slideRe_.size();
+    for (size_t k=0; k<bins; k++) {
+        slideRe_[k] = fft[k].real();
+        slideIm_[k] = fft[k].imag();
+    }
+    sinceSync_ = 0;
+}
+
+void PsdEngine::transformPair(const float* first, const float* second, std::complex<float>* out){
+    // with z = a + jb and Z its transform,
+    //   A[k] = (Z[k] + conj(Z[N-k]))/2
+    //   B[k] = (Z[k] - conj(Z[N-k]))/2j
+    // the spectrum of b is kept in packedOut_ for the next frame
+    std::complex<float>* z = &complexIn_[0];
+    for (size_t i=0; i<fftSz_; i++)
+        z[i] = std::complex<float>(first[i], second[i]);
+    fftwf_execute(packedPlan_);
+
+    const std::complex<float>* Z = &packedFft_[0];
+    std::complex<float>* next = &packedOut_[0];
+    size_t bins = fftSz_/2+1;
+    for (size_t k=0; k<bins; k++) {
+        std::complex<float> zk = Z[k];
+        std::complex<float> zc = std::conj(Z[k ? fftSz_-k : 0]);
+        std::complex<float> sum = zk + zc;
+        std::complex<float> diff = zk - zc;
+        out[k] = std::complex<float>(0.5f*sum.real(), 0.5f*sum.imag());
+        next[k] = std::complex<float>(0.5f*diff.imag(), -0.5f*diff.real());
+    }
+}
+
+void PsdEngine::goertzel(const float* data, size_t length, bool complex, std::complex<float>* out){
+    // s[n] = x[n] + 2cos(w)s[n-1] - s[n-2], run for all bins at once so that
+    // the inner loop vectorizes; complex input runs the real and imaginary
+    // parts through the same (real) recursion
+    size_t bins = coeff_.size();
+    const double* coeff = &coeff_[0];
+    stateRe1_.assign(bins, 0.0);
+    stateRe2_.assign(bins, 0.0);
+    double* re1 = &stateRe1_[0];
+    double* re2 = &stateRe2_[0];
+    if (complex) {
+        stateIm1_.assign(bins, 0.0);
+        stateIm2_.assign(bins, 0.0);
+        double* im1 = &stateIm1_[0];
+        double* im2 = &stateIm2_[0];
+        for (size_t n=0; n<length; n++) {
+            double xr = data[2*n];
+            double xi = data[2*n+1];
+            for (size_t k=0; k<bins; k++) {
+                double sr = xr + coeff[k]*re1[k] - re2[k];
+                double si = xi + coeff[k]*im1[k] - im2[k];
+                re2[k] = re1[k];
+                re1[k] = sr;
+                im2[k] = im1[k];
+                im1[k] = si;
+            }
+        }
+    } else {
+        for (size_t n=0; n<length; n++) {
+            double x = data[n];
+            for (size_t k=0; k<bins; k++) {
+                double s = x + coeff[k]*re1[k] - re2[k];
+                re2[k] = re1[k];
+                re1[k] = s;
+            }
+        }
+    }
+
+    // X(w) = (s[L-1] - exp(-jw)s[L-2]) * exp(-jw(L-1)) for L input samples
+    for (size_t k=0; k<bins; k++) {
+        std::complex<double> s1(re1[k], complex ? stateIm1_[k] : 0.0);
+        std::complex<double> s2(re2[k], complex ? stateIm2_[k] : 0.0);
+        double w = omega_[k];
+        std::complex<double> y = s1 - std::polar(1.0, -w)*s2;
+        double phase = length > 0 ? -w*(length-1) : 0.0;
+        out[k] = std::complex<float>(y*std::polar(1.0, phase));
+    }
+}
+
+bool PsdEngine::process(const float* data, size_t length, bool complex, bool doPSD,
+                        std::complex<float>* fftDest, float* psdDest,
+                        const float* following){
+    length = std::min(length, fftSz_);
+    prepare(complex);
+
+    size_t bins = outputLength(complex);
+
+    std::complex<float>* fft = &fftOut_[0];
+    const float* power = NULL;
+    if (useGoertzel_) {
+        if (fftDest)
+            fft = fftDest;
+        goertzel(data, length, complex, fft);
+    } else if (multitaper()) {
+        if (fftDest)
+            fft = fftDest;
+        multitaper_.transform(data, length, fft, &taperPower_[0]);
+        power = &taperPower_[0];
+    } else if (packedNext_) {
+        // second frame of a packed pair; transformed along with the first
+        packedNext_ = false;
+        if (fftDest) {
+            memcpy(fftDest, &packedOut_[0], bins*sizeof(std::complex<float>));
+            fft = fftDest;
+        } else {
+            fft = &packedOut_[0];
+        }
+    } else if (packedPlan_ && following && !complex && length == fftSz_ && slideMode_ == SLIDE_OFF) {
+        if (fftDest)
+            fft = fftDest;
+        transformPair(data, following, fft);
+        packedNext_ = true;
+    } else if (canSlide(data, length, complex) &&
+               (slideMode_ == SLIDE_ON || slideTrials_ <= fftTrials_)) {
+        if (fftDest)
+            fft = fftDest;
+        double start = (slideMode_ == SLIDE_UNDECIDED) ? monotonicTime() : 0;
+        slide(data, complex, fft);
+        if (slideMode_ == SLIDE_UNDECIDED) {
+            slideTime_ += monotonicTime()-start;
+            slideTrials_++;
+        }
+    } else {
+        double start = (slideMode_ == SLIDE_UNDECIDED) ? monotonicTime() : 0;
+
+        // transform straight into the caller's buffer if fftw can use it
+        if (fftDest && sparseBins_.empty() &&
+            fftwf_alignment_of(reinterpret_cast<float*>(fftDest)) ==
+            fftwf_alignment_of(reinterpret_cast<float*>(fft))) {
+            fft = fftDest;
+        }
+
+        if (complex) {
+            // complex output is centered on DC; for even sizes, modulating the
+            // input by (-1)^n during the copy does the fftshift for free
+            const std::complex<float>* in = reinterpret_cast<const std::complex<float>*>(data);
+            if (fftSz_ % 2 == 0) {
+                for (size_t i=0; i<length; i++)
+                    complexIn_[i] = (i & 1) ? -in[i] : in[i];
+            } else {
+                memcpy(&complexIn_[0], in, length*sizeof(std::complex<float>));
+            }
+            if (length < fftSz_)
+                std::fill(complexIn_.begin()+length, complexIn_.end(), std::complex<float>(0,0));
+            fftwf_execute_dft(plan_, reinterpret_cast<fftwf_complex*>(&complexIn_[0]),
+                              reinterpret_cast<fftwf_complex*>(fft));
+            if (fftSz_ % 2 != 0)
+                std::rotate(fft, fft+(fftSz_+1)/2, fft+fftSz_);
+        } else {
+            memcpy(&realIn_[0], data, length*sizeof(float));
+            if (length < fftSz_)
+                std::fill(realIn_.begin()+length, realIn_.end(), 0.0f);
+            fftwf_execute_dft_r2c(plan_, &realIn_[0], reinterpret_cast<fftwf_complex*>(fft));
+        }
+
+        if (!gather_.empty()) {
+            // pick the sparse bins out of the full transform
+            std::complex<float>* out = fftDest ? fftDest : &sparseOut_[0];
+            for (size_t i=0; i<gather_.size(); i++)
+                out[i] = fft[gather_[i]];
+            fft = out;
+        } else if (fftDest && fft != fftDest) {
+            memcpy(fftDest, fft, bins*sizeof(std::complex<float>));
+            fft = fftDest;
+        }
+
+        if (slideMode_ != SLIDE_OFF && length == fftSz_) {
+            syncSlide(fft);
+            if (slideMode_ == SLIDE_UNDECIDED && prevValid_) {
+                fftTime_ += monotonicTime()-start;
+                fftTrials_++;
+            }
+        }
+    }
+
+    if (slideMode_ != SLIDE_OFF) {
+        // keep the frame for the next update, then settle on a method once
+        // both have been timed
+        if (length == fftSz_) {
+            memcpy(&prevIn_[0], data, prevIn_.size()*sizeof(float));
+            prevValid_ = true;
+        } else {
+            prevValid_ = false;
+        }
+        if (slideMode_ == SLIDE_UNDECIDED && slideTrials_ >= SLIDE_TRIALS && fftTrials_ >= SLIDE_TRIALS)
+            slideMode_ = (slideTime_ < fftTime_) ? SLIDE_ON : SLIDE_OFF;
+    }
+    return finishFrame(fft, bins, doPSD, psdDest, power);
+}
+
+bool PsdEngine::processSpectrum(std::complex<float>* fft, bool complex, bool doPSD, float* psdDest){
+    size_t bins = outputLength(complex);
+    if (psdAverage_.size() != bins) {
+        psdOut_.resize(bins);
+        psdAverage_.resize(bins);
+        avgCount_ = 0;
+    }
+    // the frame went around the sliding dft
+    prevValid_ = false;
+    packedNext_ = false;
+    return finishFrame(fft, bins, doPSD, psdDest);
+}
+
+bool PsdEngine::finishFrame(std::complex<float>* fft, size_t bins, bool doPSD, float* psdDest,
+                            const float* power){
+    fftPtr_ = fft;
+    fftLen_ = bins;
+
+    // occupancy is counted whether or not a psd is wanted
+    if (occupancyEnabled_) {
+        if (occupancy_.bins() != bins)
+            occupancy_.configure(bins, occupancy_.threshold());
+        if (power)
+            occupancy_.add(power);
+        else
+            occupancy_.add(fft);
+    }
+
+    psdReady_ = false;
+    if (!doPSD)
+        return false;
+
+    // the power of each bin is |fft|^2 unless it was estimated separately
+    float* psd = psdDest ? psdDest : &psdOut_[0];
+    bool ready = power ? average(power, bins, psd) : average(fft, bins, psd);
+    if (!ready)
+        return false;
+
+    psdPtr_ = psd;
+    psdLen_ = bins;
+    psdReady_ = true;
+    return true;
+}
+
+template <class T>
+bool PsdEngine::average(const T* frame, size_t bins, float* psd){
+    if (numAvg_ > 1 && averageMode_ == AVERAGE_PERCENTILE) {
+        if (psdPercentile_.bins() != bins) {
+            psdPercentile_.configure(bins, percentile_);
+            avgCount_ = 0;
+        }
+        if (avgCount_ == 0)
+            psdPercentile_.reset();
+        psdPercentile_.add(frame);
+        if (++avgCount_ < numAvg_)
+            return false;
+        avgCount_ = 0;
+
+        psdPercentile_.result(psd);
+        if (logCoeff_ > 0) {
+            for (size_t i=0; i<bins; i++)
+                psd[i] = logCoeff_*log10(psd[i]);
+        }
+    } else if (numAvg_ > 1) {
+        float* avg = &psdAverage_[0];
+        if (avgCount_ == 0) {
+            for (size_t i=0; i<bins; i++)
+                avg[i] = binPower(frame[i]);
+        } else {
+            for (size_t i=0; i<bins; i++)
+                avg[i] += binPower(frame[i]);
+        }
+        if (++avgCount_ < numAvg_)
+            return false;
+        avgCount_ = 0;
+
+        // the division and the log share one pass into the destination
+        float scale = 1.0f/numAvg_;
+        if (logCoeff_ > 0) {
+            for (size_t i=0; i<bins; i++)
+                psd[i] = logCoeff_*log10(avg[i]*scale);
+        } else {
+            for (size_t i=0; i<bins; i++)
+                psd[i] = avg[i]*scale;
+        }
+    } else {
+        if (logCoeff_ > 0) {
+            for (size_t i=0; i<bins; i++)
+                psd[i] = logCoeff_*log10(binPower(frame[i]));
+        } else {
+            for (size_t i=0; i<bins; i++)
+                psd[i] = binPower(frame[i]);
+        }
+    }
+
+    return true;
+}
+
+PsdEngineSettings::PsdEngineSettings() :
+    stride(0),
+    numAvg(1),
+    logCoeff(0),
+    averageMode(PsdEngine::AVERAGE_MEAN),
+    percentile(50.0),
+    tapers(0),
+    bandwidth(0),
+    packedReal(false),
+    occupancy(false),
+    occupancyThreshold(0)
+{
+}
+
+bool PsdEngineSettings::operator==(const PsdEngineSettings& other) const{
+    return stride == other.stride && numAvg == other.numAvg && logCoeff == other.logCoeff &&
+        averageMode == other.averageMode && percentile == other.percentile &&
+        tapers == other.tapers && bandwidth == other.bandwidth &&
+        packedReal == other.packedReal && occupancy == other.occupancy &&
+        occupancyThreshold == other.occupancyThreshold && sparseBins == other.sparseBins;
+}
+
+PsdEngineBuilder::PsdEngineBuilder(){
+}
+
+void PsdEngineBuilder::start(size_t fftSize, const PsdEngineSettings& settings, bool complex,
+                             const ThreadPlacement& placement){
+    boost::shared_ptr<Job> job(new Job());
+    job->fftSize = fftSize;
+    job->settings = settings;
+    job->complex = complex;
+    job->placement = placement;
+    // planning runs at normal priority, whatever the processing thread uses
+    job->placement.priority = 0;
+    launch(job);
+}
+
+void PsdEngineBuilder::warm(size_t fftSize, size_t stride, bool complex){
+    boost::shared_ptr<Job> job(new Job());
+    job->fftSize = fftSize;
+    job->settings.stride = stride;
+    job->complex = complex;
+    job->keep = false;
+    launch(job);
+}
+
+void PsdEngineBuilder::launch(const boost::shared_ptr<Job>& job){
+    job_ = job;
+    // the thread holds its own reference to the job, so it can be detached
+    boost::thread(boost::bind(&PsdEngineBuilder::build, job)).detach();
+}
+
+bool PsdEngineBuilder::ready() const{
+    if (!job_)
+        return false;
+    boost::mutex::scoped_lock lock(job_->lock);
+    return job_->done;
+}
+
+void PsdEngineBuilder::cancel(){
+    if (job_) {
+        boost::mutex::scoped_lock lock(job_->lock);
+        job_->cancelled = true;
+    }
+    job_.reset();
+}
+
+boost::mutex& PsdEngineBuilder::warmLock(){
+    static boost::mutex lock;
+    return lock;
+}
+
+bool PsdEngineBuilder::building(size_t fftSize, const PsdEngineSettings& settings, bool complex) const{
+    return job_ && job_->fftSize == fftSize && job_->settings == settings && job_->complex == complex;
+}
+
+PsdEngine* PsdEngineBuilder::take(){
+    if (!job_)
+        return NULL;
+    PsdEngine* engine = NULL;
+    {
+        boost::mutex::scoped_lock lock(job_->lock);
+        if (!job_->done)
+            return NULL;
+        engine = job_->engine;
+        job_->engine = NULL;
+    }
+    job_.reset();
+    return engine;
+}
+
+void PsdEngineBuilder::build(boost::shared_ptr<Job> job){
+    // warming is queued here rather than on the plan lock, so that a
+    // request cancelled while it waits is dropped without being planned
+    boost::mutex::scoped_lock queue(warmLock(), boost::defer_lock);
+    if (!job->keep)
+        queue.lock();
+    {
+        boost::mutex::scoped_lock lock(job->lock);
+        if (job->cancelled) {
+            job->done = true;
+            return;
+        }
+    }
+
+    std::string error;
+    applyThreadPlacement(job->placement, error);
+
+    // everything that decides how the transform is planned has to be set
+    // before prepare(), or the processing thread replans it on first use
+    PsdEngine* engine = new PsdEngine(job->fftSize, job->settings.numAvg, job->settings.logCoeff);
+    engine->apply(job->settings);
+    engine->prepare(job->complex);
+
+    boost::mutex::scoped_lock lock(job->lock);
+    if (job->keep) {
+        job->engine = engine;
+    } else {
+        delete engine;
+    }
+    job->done = true;
+}
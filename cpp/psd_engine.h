@@ -0,0 +1,336 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef PSD_ENGINE_H
+#define PSD_ENGINE_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <fftw3.h>
+#include "huge_pages.h"
+#include "multitaper.h"
+#include "occupancy_counter.h"
+#include "percentile_average.h"
+#include "thread_placement.h"
+
+// frequency axis of the fft/psd output for a given input sample spacing
+// real input produces fftSize/2+1 bins starting at DC; complex input
+// produces fftSize bins centered on DC
+struct PsdFrequencyAxis {
+    PsdFrequencyAxis(double xdelta_in, size_t fftSize, bool complex);
+    double xstart;
+    double xdelta;
+    size_t bins;
+};
+
+struct PsdEngineSettings;
+
+class PsdEngine
+{
+    //frame-at-a-time psd processing with no redhawk dependencies
+    //handles real/complex transitions, psd averaging and db conversion
+    //the caller is responsible for framing (fftSize/overlap) and output
+    //
+    //shared by PsdProcessor and the offline psd_batch driver so that both
+    //produce identical results for the same parameters
+public:
+    PsdEngine(size_t fftSize, size_t numAvg, float logCoeff);
+    ~PsdEngine();
+
+    void setFftSize(size_t fftSize);
+    void setNumAvg(size_t numAvg);
+    void setLogCoefficient(float logCoeff);
+
+    // how the numAvg frames of a psd output are combined: the mean of each
+    // bin, or a percentile (50 for the median), which is not pulled up by
+    // short bursts of interference the way the mean is
+    enum AverageMode { AVERAGE_MEAN, AVERAGE_PERCENTILE };
+    void setAveraging(AverageMode mode, double percentile=50.0);
+    size_t fftSize() const { return fftSz_; }
+
+    // distance between consecutive frames, in samples.  with a small stride
+    // the spectrum can be updated with a sliding dft instead of a new fft;
+    // the engine times both and keeps the faster one.  0 (the default)
+    // always uses the fft
+    void setStride(size_t stride);
+    bool sliding() const { return slideMode_ == SLIDE_ON; }
+
+    // transform pairs of full real frames with one complex fft of the same
+    // size (z = a + jb), separating the two spectra by their conjugate
+    // symmetry.  pairs are formed when process() is given the following
+    // frame; not used alongside the sliding dft or sparse bins
+    void setPackedReal(bool packed);
+    bool packedReal() const { return packed_; }
+
+    // estimate the psd of each frame with Thomson's multitaper method,
+    // using this many DPSS tapers of the given time-bandwidth product (NW)
+    // and adaptive weighting.  the fft output is that of the first taper.
+    // 0 tapers restores the plain periodogram; not used with sparse bins,
+    // and replaces the sliding dft and packed real transforms
+    void setMultitaper(size_t tapers, double bandwidth);
+    bool multitaper() const { return tapers_ > 0 && bandwidth_ > 0 && sparseBins_.empty(); }
+
+    // count, for each bin, the frames whose power (linear, before any
+    // averaging) is above threshold.  counting continues across psd
+    // outputs until takeOccupancy().  changing the threshold restarts it
+    void setOccupancy(bool enable, float threshold);
+    size_t occupancyFrames() const { return occupancy_.frames(); }
+    void resetOccupancy() { occupancy_.reset(); }
+    // fraction of the frames counted that were above the threshold in each
+    // bin (outputLength() elements); the count then restarts
+    void takeOccupancy(float* fraction);
+
+    // number of fft/psd bins produced per frame
+    size_t outputLength(bool complex) const {
+        if (!sparseBins_.empty())
+            return sparseBins_.size();
+        return complex ? fftSz_ : fftSz_/2+1;
+    }
+
+    // compute only the given output bins.  positions are in units of the
+    // full output's bins and may be fractional; an empty list restores the
+    // full transform.  few bins are computed with the Goertzel algorithm,
+    // more than sparseCrossover() with the fft
+    void setSparseBins(const std::vector<double>& bins);
+    const std::vector<double>& sparseBins() const { return sparseBins_; }
+    size_t sparseCrossover() const;
+
+    // true if the next process() call will complete a psd frame, so that
+    // the caller only needs to supply a psd destination when one is due
+    bool psdDue() const { return numAvg_ <= 1 || avgCount_+1 >= numAvg_; }
+
+    // apply everything but the fft size at once; each setter leaves the
+    // transform alone if its value has not changed
+    void apply(const PsdEngineSettings& settings);
+
+    // drop any partial average
+    void flush();
+
+    // build the buffers and transform for the given input type now rather
+    // than on the first frame; process() does this as needed
+    void prepare(bool complex);
+
+    // free all buffers and plans.  they are rebuilt by the next process()
+    // call, so the memory is first touched by (and local to) that thread
+    void release();
+
+    // transform one frame; length is in samples (complex pairs for complex
+    // data) and frames shorter than fftSize are zero padded.  returns true if
+    // a psd frame is ready (always, unless averaging is in progress)
+    //
+    // fftDest and psdDest optionally receive the fft and the finished psd
+    // (outputLength() elements) in place of the internal buffers.  fftDest
+    // is transformed into directly when it has fftw alignment
+    //
+    // with packed real transforms, following may give the full frame that
+    // the next call will process; both are then transformed together and
+    // the next call uses the stored result.  the caller must make that call
+    // with the same data before any other
+    bool process(const float* data, size_t length, bool complex, bool doPSD,
+                 std::complex<float>* fftDest=NULL, float* psdDest=NULL,
+                 const float* following=NULL);
+
+    // averaging, psd and log for a full frame transformed elsewhere (see
+    // FrameBatcher), laid out like the fft output of process().  not for
+    // use with sparse bins or multitaper
+    bool processSpectrum(std::complex<float>* fft, bool complex, bool doPSD, float* psdDest=NULL);
+
+    // results of the last process() call
+    std::complex<float>* fft() { return fftPtr_; }
+    size_t fftLength() const { return fftLen_; }
+    float* psd() { return psdReady_ ? psdPtr_ : NULL; }
+    size_t psdLength() const { return psdReady_ ? psdLen_ : 0; }
+
+    // FFTW planning is not thread safe; serializes plan creation and
+    // destruction for every transform in the process
+    static boost::mutex& planLock();
+
+private:
+    PsdEngine(const PsdEngine&);
+    PsdEngine& operator=(const PsdEngine&);
+
+    void setup(bool complex);
+    void destroyPlan();
+    void goertzel(const float* data, size_t length, bool complex, std::complex<float>* out);
+    void setupSlide(bool complex);
+    bool canSlide(const float* data, size_t length, bool complex) const;
+    void slide(const float* data, bool complex, std::complex<float>* out);
+    void syncSlide(const std::complex<float>* fft);
+    bool finishFrame(std::complex<float>* fft, size_t bins, bool doPSD, float* psdDest,
+                     const float* power=NULL);
+    template <class T>
+    bool average(const T* frame, size_t bins, float* psd);
+    void transformPair(const float* first, const float* second, std::complex<float>* out);
+
+    size_t fftSz_;
+    size_t numAvg_;
+    float logCoeff_;
+
+    // transform for the current size and input type
+    fftwf_plan plan_;
+    bool planComplex_;
+    size_t planSize_;
+
+    //internal processing vectors
+    RealHugeVector realIn_;
+    ComplexHugeVector complexIn_;
+    ComplexHugeVector fftOut_;
+    RealHugeVector psdOut_;
+
+    // sparse output bins; the Goertzel state is kept per bin so that the
+    // inner loop runs across bins
+    std::vector<double> sparseBins_;
+    bool useGoertzel_;
+    std::vector<double> omega_;
+    std::vector<double> coeff_;
+    std::vector<double> stateRe1_, stateRe2_;
+    std::vector<double> stateIm1_, stateIm2_;
+    std::vector<size_t> gather_;
+    ComplexHugeVector sparseOut_;
+
+    // packed real transforms: the complex plan, its output, and the second
+    // frame's spectrum waiting for the next process() call
+    bool packed_;
+    fftwf_plan packedPlan_;
+    ComplexHugeVector packedFft_;
+    ComplexHugeVector packedOut_;
+    bool packedNext_;
+
+    // multitaper estimate and its power per bin
+    size_t tapers_;
+    double bandwidth_;
+    Multitaper multitaper_;
+    RealHugeVector taperPower_;
+
+    // occupancy counts, when enabled
+    bool occupancyEnabled_;
+    OccupancyCounter occupancy_;
+
+    // sliding dft state: the spectrum in double precision (output bin
+    // order), the per-bin twiddle exp(-j2pi k/N) and the rotation
+    // exp(j2pi k stride/N).  the state is resynchronized with a full fft
+    // every fftSize samples to bound the accumulated rounding error
+    enum SlideMode { SLIDE_UNDECIDED, SLIDE_OFF, SLIDE_ON };
+    size_t stride_;
+    SlideMode slideMode_;
+    std::vector<float> prevIn_;
+    bool prevValid_;
+    size_t sinceSync_;
+    std::vector<double> slideRe_, slideIm_;
+    std::vector<double> twiddleRe_, twiddleIm_;
+    std::vector<double> rotateRe_, rotateIm_;
+    std::vector<double> accRe_, accIm_, curRe_, curIm_;
+    double fftTime_, slideTime_;
+    size_t fftTrials_, slideTrials_;
+
+    // running sum for psd averaging, or the per-bin percentile estimate
+    AverageMode averageMode_;
+    double percentile_;
+    RealHugeVector psdAverage_;
+    PercentileAverage psdPercentile_;
+    size_t avgCount_;
+
+    std::complex<float>* fftPtr_;
+    size_t fftLen_;
+    bool psdReady_;
+    float* psdPtr_;
+    size_t psdLen_;
+};
+
+struct PsdEngineSettings
+{
+    //the configuration of a PsdEngine other than its fft size, so that an
+    //engine built elsewhere can be made to match the one it replaces
+    PsdEngineSettings();
+    bool operator==(const PsdEngineSettings& other) const;
+    bool operator!=(const PsdEngineSettings& other) const { return !(*this == other); }
+
+    size_t stride;
+    size_t numAvg;
+    float logCoeff;
+    PsdEngine::AverageMode averageMode;
+    double percentile;
+    size_t tapers;
+    double bandwidth;
+    bool packedReal;
+    bool occupancy;
+    float occupancyThreshold;
+    std::vector<double> sparseBins;
+};
+
+class PsdEngineBuilder
+{
+    //builds and plans a PsdEngine on a helper thread, so that the thread
+    //processing a stream can keep using its current engine, at the current
+    //size, until the replacement is ready
+    //
+    //only the most recent request is kept; starting a new one abandons any
+    //build in progress (it finishes in the background and is discarded).
+    //warm() requests are planned one at a time, and one cancelled before its
+    //turn is skipped
+public:
+    PsdEngineBuilder();
+
+    // placement is applied to the helper thread so that the new buffers
+    // are allocated where the processing thread runs
+    void start(size_t fftSize, const PsdEngineSettings& settings, bool complex,
+               const ThreadPlacement& placement);
+    // abandon the current request; it is not planned if it has not started
+    void cancel();
+
+    // plan the transform for this configuration without keeping the engine.
+    // fftw remembers what it measured (its wisdom), so any engine of the same
+    // size and type plans almost instantly afterwards
+    void warm(size_t fftSize, size_t stride, bool complex);
+
+    // true once the last start() or warm() has finished
+    bool ready() const;
+
+    // true if a build for this configuration has been started
+    bool building(size_t fftSize, const PsdEngineSettings& settings, bool complex) const;
+
+    // the finished engine, which the caller then owns; NULL until the build
+    // has completed
+    PsdEngine* take();
+
+private:
+    struct Job {
+        Job() : done(false), keep(true), cancelled(false), engine(NULL) {}
+        ~Job() { delete engine; }
+        boost::mutex lock;
+        bool done;
+        bool keep;
+        bool cancelled;
+        PsdEngine* engine;
+        size_t fftSize;
+        PsdEngineSettings settings;
+        bool complex;
+        ThreadPlacement placement;
+    };
+    void launch(const boost::shared_ptr<Job>& job);
+    static void build(boost::shared_ptr<Job> job);
+    static boost::mutex& warmLock();
+
+    boost::shared_ptr<Job> job_;
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "sample_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // smallest ring allocated, in floats
+    const size_t MIN_CAPACITY = 16384;
+}
+
+SampleBuffer::SampleBuffer() :
+    head_(0),
+    complex_(false),
+    xdelta_(1.0),
+    begin_(0),
+    end_(0)
+{
+}
+
+void SampleBuffer::reset(){
+    head_ = 0;
+    anchors_.clear();
+    begin_ = 0;
+    end_ = 0;
+}
+
+void SampleBuffer::append(const float* data, size_t samples, bool complex,
+                          const BULKIO::PrecisionUTCTime& time, double xdelta){
+    if (complex != complex_) {
+        // the layout changed; nothing buffered can be framed with new data
+        head_ = 0;
+        complex_ = complex;
+        if (begin_ < end_)
+            begin_ = end_;
+    }
+    xdelta_ = xdelta;
+
+    Anchor anchor;
+    anchor.index = end_;
+    anchor.time = time;
+    anchors_.push_back(anchor);
+
+    // skip anything already released
+    size_t skip = 0;
+    if (begin_ > end_)
+        skip = std::min<uint64_t>(begin_-end_, samples);
+    if (skip < samples) {
+        size_t floats = (samples-skip)*width();
+        reserve(stored() + floats);
+        if (!ring_.mirrored() && head_+stored()+floats > capacity()) {
+            // no mirror; move the samples held back to the start instead
+            std::memmove(ring(), ring()+head_, stored()*sizeof(float));
+            head_ = 0;
+        }
+        // the tail may run past the end of the ring into the mirror
+        size_t tail = head_ + stored();
+        if (ring_.mirrored())
+            tail %= capacity();
+        std::memcpy(ring()+tail, data+skip*width(), floats*sizeof(float));
+    }
+    end_ += samples;
+}
+
+void SampleBuffer::reserve(size_t floats){
+    if (floats <= capacity())
+        return;
+    size_t size = std::max(capacity(), MIN_CAPACITY);
+    while (size < floats)
+        size *= 2;
+
+    MirroredBuffer larger;
+    larger.allocate(size*sizeof(float));
+    // the samples held are contiguous, even across the end of the old ring
+    if (stored())
+        std::memcpy(larger.data(), ring()+head_, stored()*sizeof(float));
+    ring_.swap(larger);
+    head_ = 0;
+}
+
+void SampleBuffer::release(uint64_t index){
+    if (index <= begin_)
+        return;
+    size_t drop = std::min<uint64_t>(index, end_) - std::min<uint64_t>(begin_, end_);
+    head_ += drop*width();
+    if (ring_.mirrored() && head_ >= capacity())
+        head_ -= capacity();
+    begin_ = index;
+    if (begin_ >= end_)
+        head_ = 0;
+
+    // keep the last anchor at or before the new beginning
+    while (anchors_.size() > 1 && anchors_[1].index <= begin_)
+        anchors_.pop_front();
+}
+
+const float* SampleBuffer::data(uint64_t index) const{
+    size_t offset = head_ + (index-begin_)*width();
+    if (ring_.mirrored() && offset >= capacity())
+        offset -= capacity();
+    return ring() + offset;
+}
+
+BULKIO::PrecisionUTCTime SampleBuffer::time(uint64_t index) const{
+    if (anchors_.empty())
+        return bulkio::time::utils::notSet();
+    std::deque<Anchor>::const_reverse_iterator anchor = anchors_.rbegin();
+    while (anchor != anchors_.rend() && anchor->index > index)
+        ++anchor;
+    if (anchor == anchors_.rend())
+        --anchor;
+    if (anchor->index == index)
+        return anchor->time;
+    return anchor->time + (double(index)-double(anchor->index))*xdelta_;
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include <deque>
+#include <stdint.h>
+#include <bulkio/bulkio.h>
+
+#include "mirrored_buffer.h"
+
+class SampleBuffer
+{
+    //input samples of one stream, shared by all of its fft resolutions
+    //
+    //samples are addressed by their absolute index since the last reset
+    //(a complex sample counts once) so that each resolution can keep its own
+    //frame position.  the time stamp of any buffered sample is derived from
+    //the packet time stamps and the sample spacing
+    //
+    //the samples are kept in a ring mapped twice in a row (MirroredBuffer),
+    //so every frame is contiguous wherever it falls in the ring; releasing
+    //samples only moves the read position and frames are read in place
+public:
+    SampleBuffer();
+
+    // drop all samples and restart indexing at 0
+    void reset();
+
+    void append(const float* data, size_t samples, bool complex,
+                const BULKIO::PrecisionUTCTime& time, double xdelta);
+
+    // samples no longer needed by any resolution.  index may be past end(),
+    // in which case the samples up to it are discarded as they arrive
+    void release(uint64_t index);
+
+    uint64_t begin() const { return begin_; }
+    uint64_t end() const { return end_; }
+    bool complex() const { return complex_; }
+
+    // number of samples available from index to end()
+    size_t available(uint64_t index) const { return index < end_ ? end_-index : 0; }
+
+    // data starting at the sample at index; index must be in [begin(), end())
+    const float* data(uint64_t index) const;
+
+    BULKIO::PrecisionUTCTime time(uint64_t index) const;
+
+private:
+    struct Anchor {
+        uint64_t index;
+        BULKIO::PrecisionUTCTime time;
+    };
+
+    size_t width() const { return complex_ ? 2 : 1; }
+    // number of floats held, from begin() to end()
+    size_t stored() const { return begin_ < end_ ? (end_-begin_)*width() : 0; }
+    size_t capacity() const { return ring_.size() / sizeof(float); }
+    float* ring() const { return reinterpret_cast<float*>(ring_.data()); }
+    void reserve(size_t floats);
+
+    MirroredBuffer ring_;
+    // position of the sample at begin() in the ring, in floats
+    size_t head_;
+    bool complex_;
+    double xdelta_;
+    uint64_t begin_;
+    uint64_t end_;
+    std::deque<Anchor> anchors_;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef STRUCTPROPS_H
+#define STRUCTPROPS_H
+
+/*******************************************************************************************
+
+    AUTO-GENERATED CODE. DO NOT MODIFY
+
+*******************************************************************************************/
+
+#include <ossie/CorbaUtils.h>
+#include <CF/cf.h>
+#include <ossie/PropertyMap.h>
+
+struct historyReplay_struct {
+    historyReplay_struct ()
+    {
+        startTime = 0.0;
+        stopTime = 0.0;
+    }
+
+    static std::string getId() {
+        return std::string("historyReplay");
+    }
+
+    static const char* getFormat() {
+        return "sdds";
+    }
+
+    std::string streamID;
+    double startTime;
+    double stopTime;
+    std::string exportFile;
+};
+
+inline bool operator>>= (const CORBA::Any& a, historyReplay_struct& s) {
+    CF::Properties* temp;
+    if (!(a >>= temp)) return false;
+    const redhawk::PropertyMap& props = redhawk::PropertyMap::cast(*temp);
+    if (props.contains("historyReplay::streamID")) {
+        if (!(props["historyReplay::streamID"] >>= s.streamID)) return false;
+    }
+    if (props.contains("historyReplay::startTime")) {
+        if (!(props["historyReplay::startTime"] >>= s.startTime)) return false;
+    }
+    if (props.contains("historyReplay::stopTime")) {
+        if (!(props["historyReplay::stopTime"] >>= s.stopTime)) return false;
+    }
+    if (props.contains("historyReplay::exportFile")) {
+        if (!(props["historyReplay::exportFile"] >>= s.exportFile)) return false;
+    }
+    return true;
+}
+
+inline void operator<<= (CORBA::Any& a, const historyReplay_struct& s) {
+    redhawk::PropertyMap props;
+ 
+    props["historyReplay::streamID"] = s.streamID;
+ 
+    props["historyReplay::startTime"] = s.startTime;
+ 
+    props["historyReplay::stopTime"] = s.stopTime;
+ 
+    props["historyReplay::exportFile"] = s.exportFile;
+    a <<= props;
+}
+
+inline bool operator== (const historyReplay_struct& s1, const historyReplay_struct& s2) {
+    if (s1.streamID!=s2.streamID)
+        return false;
+    if (s1.startTime!=s2.startTime)
+        return false;
+    if (s1.stopTime!=s2.stopTime)
+        return false;
+    if (s1.exportFile!=s2.exportFile)
+        return false;
+    return true;
+}
+
+inline bool operator!= (const historyReplay_struct& s1, const historyReplay_struct& s2) {
+    return !(s1==s2);
+}
+
+struct resolution_struct {
+    resolution_struct ()
+    {
+        fftSize = 1024;
+        overlap = 0;
+        numAvg = 0;
+    }
+
+    static std::string getId() {
+        return std::string("resolutions::resolution");
+    }
+
+    static const char* getFormat() {
+        return "IiI";
+    }
+
+    CORBA::ULong fftSize;
+    CORBA::Long overlap;
+    CORBA::ULong numAvg;
+};
+
+inline bool operator>>= (const CORBA::Any& a, resolution_struct& s) {
+    CF::Properties* temp;
+    if (!(a >>= temp)) return false;
+    const redhawk::PropertyMap& props = redhawk::PropertyMap::cast(*temp);
+    if (props.contains("resolutions::fftSize")) {
+        if (!(props["resolutions::fftSize"] >>= s.fftSize)) return false;
+    }
+    if (props.contains("resolutions::overlap")) {
+        if (!(props["resolutions::overlap"] >>= s.overlap)) return false;
+    }
+    if (props.contains("resolutions::numAvg")) {
+        if (!(props["resolutions::numAvg"] >>= s.numAvg)) return false;
+    }
+    return true;
+}
+
+inline void operator<<= (CORBA::Any& a, const resolution_struct& s) {
+    redhawk::PropertyMap props;
+ 
+    props["resolutions::fftSize"] = s.fftSize;
+ 
+    props["resolutions::overlap"] = s.overlap;
+ 
+    props["resolutions::numAvg"] = s.numAvg;
+    a <<= props;
+}
+
+inline bool operator== (const resolution_struct& s1, const resolution_struct& s2) {
+    if (s1.fftSize!=s2.fftSize)
+        return false;
+    if (s1.overlap!=s2.overlap)
+        return false;
+    if (s1.numAvg!=s2.numAvg)
+        return false;
+    return true;
+}
+
+inline bool operator!= (const resolution_struct& s1, const resolution_struct& s2) {
+    return !(s1==s2);
+}
+
+struct band_struct {
+    band_struct ()
+    {
+        name = "";
+        startFrequency = 0.0;
+        stopFrequency = 0.0;
+    }
+
+    static std::string getId() {
+        return std::string("bands::band");
+    }
+
+    static const char* getFormat() {
+        return "sdd";
+    }
+
+    std::string name;
+    double startFrequency;
+    double stopFrequency;
+};
+
+inline bool operator>>= (const CORBA::Any& a, band_struct& s) {
+    CF::Properties* temp;
+    if (!(a >>= temp)) return false;
+    const redhawk::PropertyMap& props = redhawk::PropertyMap::cast(*temp);
+    if (props.contains("bands::name")) {
+        if (!(props["bands::name"] >>= s.name)) return false;
+    }
+    if (props.contains("bands::startFrequency")) {
+        if (!(props["bands::startFrequency"] >>= s.startFrequency)) return false;
+    }
+    if (props.contains("bands::stopFrequency")) {
+        if (!(props["bands::stopFrequency"] >>= s.stopFrequency)) return false;
+    }
+    return true;
+}
+
+inline void operator<<= (CORBA::Any& a, const band_struct& s) {
+    redhawk::PropertyMap props;
+ 
+    props["bands::name"] = s.name;
+ 
+    props["bands::startFrequency"] = s.startFrequency;
+ 
+    props["bands::stopFrequency"] = s.stopFrequency;
+    a <<= props;
+}
+
+inline bool operator== (const band_struct& s1, const band_struct& s2) {
+    if (s1.name!=s2.name)
+        return false;
+    if (s1.startFrequency!=s2.startFrequency)
+        return false;
+    if (s1.stopFrequency!=s2.stopFrequency)
+        return false;
+    return true;
+}
+
+inline bool operator!= (const band_struct& s1, const band_struct& s2) {
+    return !(s1==s2);
+}
+
+#endif // STRUCTPROPS_H
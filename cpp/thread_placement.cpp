@@ -0,0 +1,96 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "thread_placement.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// from linux/mempolicy.h
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+bool parseCpuList(const std::string& text, std::vector<int>& cpus){
+    cpus.clear();
+    const char* p = text.c_str();
+    while (*p) {
+        while (*p == ' ' || *p == ',')
+            p++;
+        if (!*p)
+            break;
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0)
+            return false;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p+1, &end, 10);
+            if (end == p+1 || last < first)
+                return false;
+            p = end;
+        }
+        if (*p && *p != ',' && *p != ' ')
+            return false;
+        for (long cpu=first; cpu<=last; cpu++)
+            cpus.push_back(int(cpu));
+    }
+    return true;
+}
+
+bool applyThreadPlacement(const ThreadPlacement& placement, std::string& error){
+    error.clear();
+
+    if (!placement.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (size_t i=0; i<placement.cpus.size(); i++) {
+            if (placement.cpus[i] < CPU_SETSIZE)
+                CPU_SET(placement.cpus[i], &set);
+        }
+        int status = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (status != 0 && error.empty())
+            error = std::string("cpu affinity: ") + strerror(status);
+    }
+
+    if (placement.numaLocal) {
+        // an empty preferred node mask means "the node this thread runs on",
+        // overriding any interleave policy inherited from the process
+        if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, NULL, 0) != 0 && error.empty())
+            error = std::string("numa policy: ") + strerror(errno);
+    }
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    int policy = SCHED_OTHER;
+    if (placement.priority > 0) {
+        policy = SCHED_FIFO;
+        param.sched_priority = placement.priority;
+    }
+    int status = pthread_setschedparam(pthread_self(), policy, &param);
+    if (status != 0 && error.empty())
+        error = std::string("scheduling policy: ") + strerror(status);
+
+    return error.empty();
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+#include <string>
+#include <vector>
+
+// where and how a processing thread runs
+struct ThreadPlacement {
+    ThreadPlacement() : numaLocal(false), priority(0) {}
+
+    // cpus the thread may run on; empty leaves the affinity alone
+    std::vector<int> cpus;
+    // prefer memory on the node the thread runs on for new allocations
+    bool numaLocal;
+    // SCHED_FIFO priority; 0 leaves the default policy
+    int priority;
+
+    bool operator==(const ThreadPlacement& other) const {
+        return cpus == other.cpus && numaLocal == other.numaLocal && priority == other.priority;
+    }
+    bool operator!=(const ThreadPlacement& other) const { return !(*this == other); }
+};
+
+// parse a cpu list such as "0-3,8,10-11"; returns false on a syntax error
+bool parseCpuList(const std::string& text, std::vector<int>& cpus);
+
+// apply the placement to the calling thread.  returns false and describes
+// the first failure in error; the remaining settings are still applied
+bool applyThreadPlacement(const ThreadPlacement& placement, std::string& error);
+
+#endif
@@ -0,0 +1,360 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "waterfall_history.h"
+#include "bluefile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+PREPARE_LOGGING(WaterfallHistory)
+
+namespace {
+    const char HISTORY_MAGIC[8] = {'P','S','D','H','I','S','T','1'};
+    // 2: appended frame count in the header
+    const uint32_t HISTORY_VERSION = 2;
+
+    size_t recordSizeFor(size_t frameLength){
+        size_t size = sizeof(WaterfallHistory::Record) + frameLength*sizeof(float);
+        return (size+7) & ~size_t(7);
+    }
+
+    double seconds(const WaterfallHistory::Record& record){
+        return record.twsec + record.tfsec;
+    }
+}
+
+BULKIO::PrecisionUTCTime WaterfallHistory::Frame::time() const {
+    BULKIO::PrecisionUTCTime tstamp;
+    tstamp.tcmode = record.tcmode;
+    tstamp.tcstatus = record.tcstatus;
+    tstamp.toff = record.toff;
+    tstamp.twsec = record.twsec;
+    tstamp.tfsec = record.tfsec;
+    return tstamp;
+}
+
+BULKIO::StreamSRI WaterfallHistory::Frame::sri(const std::string& streamID) const {
+    BULKIO::StreamSRI sri = bulkio::sri::create(streamID);
+    sri.xstart = record.xstart;
+    sri.xdelta = record.xdelta;
+    sri.xunits = record.xunits;
+    sri.subsize = record.subsize;
+    sri.ydelta = record.ydelta;
+    sri.yunits = record.yunits;
+    sri.mode = record.mode;
+    return sri;
+}
+
+bool WaterfallHistory::Frame::sameSRI(const Frame& other) const {
+    return record.xstart == other.record.xstart &&
+           record.xdelta == other.record.xdelta &&
+           record.xunits == other.record.xunits &&
+           record.subsize == other.record.subsize &&
+           record.ydelta == other.record.ydelta &&
+           record.yunits == other.record.yunits &&
+           record.mode == other.record.mode;
+}
+
+WaterfallHistory::WaterfallHistory(const std::string& path, size_t maxBytes) :
+    path_(path),
+    maxBytes_(maxBytes),
+    fd_(-1),
+    map_(NULL),
+    mapSize_(0),
+    header_(NULL),
+    generation_(0)
+{
+    LOG_DEBUG(WaterfallHistory,__PRETTY_FUNCTION__<<" path="<<path_<<" maxBytes="<<maxBytes_);
+    attach();
+}
+
+WaterfallHistory::~WaterfallHistory(){
+    unmap();
+}
+
+std::string WaterfallHistory::filename(const std::string& directory, const std::string& streamID){
+    // stream IDs are free-form; keep the file name portable
+    std::string name(streamID);
+    for (size_t i=0; i<name.size(); i++){
+        char c = name[i];
+        if (!isalnum(c) && c!='-' && c!='_' && c!='.')
+            name[i] = '_';
+    }
+    return directory + "/" + name + ".psdhist";
+}
+
+void WaterfallHistory::unmap(){
+    if (map_){
+        munmap(map_, mapSize_);
+        map_ = NULL;
+        header_ = NULL;
+        mapSize_ = 0;
+    }
+    if (fd_ >= 0){
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool WaterfallHistory::attach(){
+    // reuse an existing ring file (e.g. after a restart) if it is intact
+    int flags = maxBytes_ ? O_RDWR : O_RDONLY;
+    int fd = open(path_.c_str(), flags);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    FileHeader header;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(FileHeader) ||
+        pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)) ||
+        memcmp(header.magic, HISTORY_MAGIC, sizeof(HISTORY_MAGIC)) != 0 ||
+        header.version != HISTORY_VERSION ||
+        header.recordSize != recordSizeFor(header.frameLength) ||
+        size_t(st.st_size) != sizeof(FileHeader) + header.capacity*header.recordSize) {
+        LOG_DEBUG(WaterfallHistory,"Ignoring invalid history file "<<path_);
+        close(fd);
+        return false;
+    }
+    if (maxBytes_ && size_t(st.st_size) > maxBytes_) {
+        // size limit was lowered since the file was written; start over
+        close(fd);
+        return false;
+    }
+
+    int prot = maxBytes_ ? PROT_READ|PROT_WRITE : PROT_READ;
+    void* map = mmap(NULL, st.st_size, prot, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_WARN(WaterfallHistory,"Unable to map history file "<<path_<<": "<<strerror(errno));
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    map_ = static_cast<unsigned char*>(map);
+    mapSize_ = st.st_size;
+    header_ = reinterpret_cast<FileHeader*>(map_);
+    LOG_DEBUG(WaterfallHistory,"Attached to history file "<<path_<<" with "<<header_->count<<" frames");
+    return true;
+}
+
+bool WaterfallHistory::create(size_t frameLength){
+    unmap();
+    generation_++;
+
+    size_t recordSize = recordSizeFor(frameLength);
+    size_t capacity = 1;
+    if (maxBytes_ > sizeof(FileHeader)+recordSize)
+        capacity = (maxBytes_-sizeof(FileHeader))/recordSize;
+    size_t size = sizeof(FileHeader) + capacity*recordSize;
+
+    int fd = open(path_.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_WARN(WaterfallHistory,"Unable to create history file "<<path_<<": "<<strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, size) != 0) {
+        LOG_WARN(WaterfallHistory,"Unable to size history file "<<path_<<": "<<strerror(errno));
+        close(fd);
+        return false;
+    }
+    void* map = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_WARN(WaterfallHistory,"Unable to map history file "<<path_<<": "<<strerror(errno));
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    map_ = static_cast<unsigned char*>(map);
+    mapSize_ = size;
+    header_ = reinterpret_cast<FileHeader*>(map_);
+
+    memset(header_, 0, sizeof(FileHeader));
+    memcpy(header_->magic, HISTORY_MAGIC, sizeof(HISTORY_MAGIC));
+    header_->version = HISTORY_VERSION;
+    header_->frameLength = frameLength;
+    header_->recordSize = recordSize;
+    header_->capacity = capacity;
+    LOG_DEBUG(WaterfallHistory,"Created history file "<<path_<<" for "<<capacity<<" frames of "<<frameLength);
+    return true;
+}
+
+uint64_t WaterfallHistory::appended() const{
+    return header_->appended;
+}
+
+WaterfallHistory::Record* WaterfallHistory::record(uint64_t index){
+    return reinterpret_cast<Record*>(map_ + sizeof(FileHeader) + index*header_->recordSize);
+}
+
+bool WaterfallHistory::append(const float* data, size_t length, const BULKIO::PrecisionUTCTime& time, const BULKIO::StreamSRI& sri){
+    boost::mutex::scoped_lock lock(lock_);
+    if (maxBytes_ == 0)
+        return false;
+
+    // a new frame length (fftSize or real/complex change) restarts the ring
+    if (!header_ || header_->frameLength != length){
+        if (!create(length))
+            return false;
+    }
+
+    Record* rec = record(header_->head);
+    rec->twsec = time.twsec;
+    rec->tfsec = time.tfsec;
+    rec->toff = time.toff;
+    rec->tcmode = time.tcmode;
+    rec->tcstatus = time.tcstatus;
+    rec->xunits = sri.xunits;
+    rec->yunits = sri.yunits;
+    rec->mode = sri.mode;
+    rec->subsize = sri.subsize;
+    rec->length = length;
+    rec->reserved = 0;
+    rec->xstart = sri.xstart;
+    rec->xdelta = sri.xdelta;
+    rec->ydelta = sri.ydelta;
+    memcpy(rec+1, data, length*sizeof(float));
+
+    // only publish the frame once it is completely written
+    header_->head = (header_->head+1) % header_->capacity;
+    if (header_->count < header_->capacity)
+        header_->count++;
+    header_->appended++;
+    return true;
+}
+
+bool WaterfallHistory::find(double start, double stop, Cursor& cursor){
+    boost::mutex::scoped_lock lock(lock_);
+    if (!header_ && !attach())
+        return false;
+    if (header_->count == 0)
+        return false;
+
+    uint64_t capacity = header_->capacity;
+    if (start <= 0 || stop <= 0){
+        double newest = seconds(*record((header_->head + capacity - 1) % capacity));
+        if (start <= 0)
+            start += newest;
+        if (stop <= 0)
+            stop += newest;
+    }
+    cursor.next = appended() - header_->count;
+    cursor.end = appended();
+    cursor.start = start;
+    cursor.stop = stop;
+    cursor.generation = generation_;
+    return true;
+}
+
+bool WaterfallHistory::next(Cursor& cursor, Frame& frame){
+    boost::mutex::scoped_lock lock(lock_);
+    if (!header_ || cursor.generation != generation_)
+        return false;
+
+    uint64_t capacity = header_->capacity;
+    uint64_t oldest = appended() - header_->count;
+    if (cursor.next < oldest)
+        cursor.next = oldest;
+    for (; cursor.next < cursor.end; cursor.next++){
+        uint64_t age = appended() - cursor.next;
+        const Record* rec = record((header_->head + capacity - age % capacity) % capacity);
+        double t = seconds(*rec);
+        if (t < cursor.start || t > cursor.stop)
+            continue;
+        frame.record = *rec;
+        const float* data = reinterpret_cast<const float*>(rec+1);
+        frame.data.assign(data, data+rec->length);
+        cursor.next++;
+        return true;
+    }
+    return false;
+}
+
+HistoryExport::HistoryExport() :
+    fp_(NULL),
+    frames_(0),
+    ok_(false)
+{
+}
+
+HistoryExport::~HistoryExport(){
+    close();
+}
+
+bool HistoryExport::open(const std::string& filename){
+    close();
+    filename_ = filename;
+    frames_ = 0;
+    fp_ = fopen(filename.c_str(), "wb");
+    if (!fp_) {
+        LOG_WARN(WaterfallHistory,"Unable to open export file "<<filename<<": "<<strerror(errno));
+        return false;
+    }
+    ok_ = true;
+    return true;
+}
+
+bool HistoryExport::write(const WaterfallHistory::Frame& frame){
+    if (!fp_ || !ok_)
+        return false;
+    if (frames_ == 0) {
+        // the header is written again with the data size by close()
+        first_ = frame.record;
+        unsigned char hcb[BLUE_HCB_SIZE];
+        memset(hcb, 0, sizeof(hcb));
+        ok_ = fwrite(hcb, 1, sizeof(hcb), fp_) == sizeof(hcb);
+    } else if (frame.record.length != first_.length) {
+        return false;
+    }
+    ok_ = ok_ && fwrite(&frame.data[0], sizeof(float), first_.length, fp_) == first_.length;
+    if (ok_)
+        frames_++;
+    return ok_;
+}
+
+bool HistoryExport::close(){
+    if (!fp_)
+        return false;
+
+    if (ok_ && frames_ > 0) {
+        BlueHeader header;
+        header.type = 2000;
+        header.format[0] = 'S';
+        header.format[1] = 'F';
+        header.dataSize = double(frames_)*first_.length*sizeof(float);
+        header.timecode = seconds(first_) + BLUE_J1950_OFFSET;
+        header.xstart = first_.xstart;
+        header.xdelta = first_.xdelta;
+        header.xunits = first_.xunits;
+        header.subsize = first_.length;
+        header.ystart = 0;
+        header.ydelta = first_.ydelta;
+        header.yunits = first_.yunits;
+        ok_ = fseek(fp_, 0, SEEK_SET) == 0 && writeBlueHeader(fp_, header);
+    }
+    bool ok = fclose(fp_) == 0 && ok_;
+    fp_ = NULL;
+    if (!ok)
+        LOG_WARN(WaterfallHistory,"Error writing export file "<<filename_);
+    return ok;
+}
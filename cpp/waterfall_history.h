@@ -0,0 +1,154 @@
+/*
+ * This file is protected by Copyright. Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This file is part of REDHAWK Basic Components psd.
+ *
+ * REDHAWK Basic Components psd is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * REDHAWK Basic Components psd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this
+ * program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef WATERFALL_HISTORY_H
+#define WATERFALL_HISTORY_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <boost/thread/mutex.hpp>
+#include <bulkio/bulkio.h>
+
+class WaterfallHistory
+{
+    ENABLE_LOGGING
+    //bounded on-disk history of psd output frames for a single stream
+    //
+    //frames are stored in a memory-mapped ring file together with their
+    //timestamp and the numeric fields of the output SRI.  once the file is
+    //full the oldest frames are overwritten.  the file outlives the stream so
+    //that it can still be replayed after EOS or a component restart
+public:
+    struct Record {
+        double twsec;
+        double tfsec;
+        double toff;
+        int16_t tcmode;
+        int16_t tcstatus;
+        int16_t xunits;
+        int16_t yunits;
+        int32_t mode;
+        int32_t subsize;
+        uint32_t length;
+        uint32_t reserved;
+        double xstart;
+        double xdelta;
+        double ydelta;
+    };
+
+    struct Frame {
+        Record record;
+        std::vector<float> data;
+        BULKIO::PrecisionUTCTime time() const;
+        BULKIO::StreamSRI sri(const std::string& streamID) const;
+        bool sameSRI(const Frame& other) const;
+    };
+
+    // opens (or attaches to) the ring file at path.  maxBytes bounds the file
+    // size; a value of 0 attaches read-only to an existing file
+    WaterfallHistory(const std::string& path, size_t maxBytes);
+    ~WaterfallHistory();
+
+    static std::string filename(const std::string& directory, const std::string& streamID);
+
+    bool append(const float* data, size_t length, const BULKIO::PrecisionUTCTime& time, const BULKIO::StreamSRI& sri);
+
+    // position of a replay in the ring; see find() and next()
+    struct Cursor {
+        uint64_t next;
+        uint64_t end;
+        double start;
+        double stop;
+        uint64_t generation;
+    };
+
+    // start a cursor over the frames with timestamps in [start, stop]
+    // (seconds since the unix epoch) held at the time of the call.
+    // non-positive values are taken relative to the newest frame.  returns
+    // false if there is no history
+    bool find(double start, double stop, Cursor& cursor);
+
+    // copy out the next frame of the cursor's range.  the lock is only held
+    // for that frame, so the stream keeps appending during a long replay;
+    // frames overwritten since find() are skipped.  returns false at the end
+    bool next(Cursor& cursor, Frame& frame);
+
+    const std::string& path() const { return path_; }
+    size_t maxBytes() const { return maxBytes_; }
+
+private:
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t frameLength;
+        uint64_t recordSize;
+        uint64_t capacity;
+        uint64_t head;
+        uint64_t count;
+        // frames appended since the file was created, so that a cursor can
+        // tell which of its frames have since been overwritten
+        uint64_t appended;
+        uint64_t reserved[2];
+    };
+
+    bool attach();
+    bool create(size_t frameLength);
+    void unmap();
+    Record* record(uint64_t index);
+    uint64_t appended() const;
+
+    std::string path_;
+    size_t maxBytes_;
+    int fd_;
+    unsigned char* map_;
+    size_t mapSize_;
+    FileHeader* header_;
+    // incremented whenever the ring is recreated, which ends any cursor
+    uint64_t generation_;
+    boost::mutex lock_;
+};
+
+class HistoryExport
+{
+    //writes history frames to a type 2000 BLUE file as they are read, with
+    //the data size in the header filled in by close()
+public:
+    HistoryExport();
+    ~HistoryExport();
+
+    bool open(const std::string& filename);
+
+    // the first frame sets the frame length and axes of the file; frames of
+    // a different length cannot share a type 2000 file and are left out
+    bool write(const WaterfallHistory::Frame& frame);
+
+    bool close();
+
+    size_t frames() const { return frames_; }
+
+private:
+    std::string filename_;
+    FILE* fp_;
+    WaterfallHistory::Record first_;
+    size_t frames_;
+    bool ok_;
+};
+
+#endif
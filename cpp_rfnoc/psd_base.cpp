@@ -26,6 +26,20 @@ psd_base::psd_base(const char *uuid, const char *label) :
     addPort("fft_dataFloat_out", "Float output port for the FFT of the input data. The output will be two dimentional data with a subsize of half the FFT size plus one for real input data and equal to the FFT size for complex input data. The FFT output data is always complex.  ", fft_dataFloat_out);
     psd_dataShort_out = new bulkio::OutShortPort("psd_dataShort_out");
     addPort("psd_dataShort_out", psd_dataShort_out);
+    csd_dataFloat_out = new bulkio::OutFloatPort("csd_dataFloat_out");
+    addPort("csd_dataFloat_out", "Float output port for the averaged cross-spectral density of each pair of streams listed in crossSpectralStreams. The output is complex, two dimensional data with the same subsize as the FFT output.  ", csd_dataFloat_out);
+    coherence_dataFloat_out = new bulkio::OutFloatPort("coherence_dataFloat_out");
+    addPort("coherence_dataFloat_out", "Float output port for the magnitude-squared coherence of each pair of streams listed in crossSpectralStreams. The output is real, two dimensional data with the same subsize as the FFT output.  ", coherence_dataFloat_out);
+    occupancy_dataFloat_out = new bulkio::OutFloatPort("occupancy_dataFloat_out");
+    addPort("occupancy_dataFloat_out", "Float output port for spectrum occupancy, enabled by occupancyInterval. Each frame gives, for every psd bin, the fraction of the fft frames in the interval whose power was above occupancyThreshold. The output is real, two dimensional data with the same subsize as the PSD output, on the input stream ID.  ", occupancy_dataFloat_out);
+    peaks_dataDouble_out = new bulkio::OutDoublePort("peaks_dataDouble_out");
+    addPort("peaks_dataDouble_out", "Double output port for the strongest peaks of each PSD frame, enabled by peakCount. Each packet holds up to peakCount [frequency, power] pairs for one frame, strongest first, as two dimensional data with a subsize of 2. Frequencies are on the PSD output axis (RF if rfFreqUnits is set) and power is in the PSD output units. Not available with sparse output.  ", peaks_dataDouble_out);
+    acf_dataFloat_out = new bulkio::OutFloatPort("acf_dataFloat_out");
+    addPort("acf_dataFloat_out", "Float output port for the autocorrelation of each stream, enabled by autocorrelation. Each frame is the inverse FFT of the averaged PSD, with lags from -N/2 to N/2-1 samples in time units on the x axis, where N is fftSize, or twice fftSize with autocorrelationZeroPad. The output is real for real input and complex for complex input, on the input stream ID.  ", acf_dataFloat_out);
+    bands_dataFloat_out = new bulkio::OutFloatPort("bands_dataFloat_out");
+    addPort("bands_dataFloat_out", "Float output port for the power in each band listed in bands, one frame per PSD frame. Each frame has one element per band, in the order listed and in the PSD output units; the band names and edges are in the BAND_NAMES, BAND_START_FREQUENCIES and BAND_STOP_FREQUENCIES keywords. On the input stream ID.  ", bands_dataFloat_out);
+    fft_dataShort_out = new bulkio::OutShortPort("fft_dataShort_out");
+    addPort("fft_dataShort_out", "Short output port for the FFT as 16-bit block floating point, at half the bandwidth of fft_dataFloat_out. Each frame is complex and starts with one extra element whose real part is the frame's exponent e; every following value is the integer times 2^e. The SRI is that of the FFT output with the axis extended one bin down for that element, and the BFP_EXPONENT_ELEMENTS keyword.  ", fft_dataShort_out);
 }
 
 psd_base::~psd_base()
@@ -40,6 +54,20 @@ psd_base::~psd_base()
     fft_dataFloat_out = 0;
     delete psd_dataShort_out;
     psd_dataShort_out = 0;
+    delete csd_dataFloat_out;
+    csd_dataFloat_out = 0;
+    delete coherence_dataFloat_out;
+    coherence_dataFloat_out = 0;
+    delete occupancy_dataFloat_out;
+    occupancy_dataFloat_out = 0;
+    delete peaks_dataDouble_out;
+    peaks_dataDouble_out = 0;
+    delete acf_dataFloat_out;
+    acf_dataFloat_out = 0;
+    delete bands_dataFloat_out;
+    bands_dataFloat_out = 0;
+    delete fft_dataShort_out;
+    fft_dataShort_out = 0;
 }
 
 /*******************************************************************************************
@@ -45,6 +45,20 @@ class psd_base : public Component, protected ThreadedComponent
         bulkio::OutFloatPort *fft_dataFloat_out;
         /// Port: psd_dataShort_out
         bulkio::OutShortPort *psd_dataShort_out;
+        /// Port: csd_dataFloat_out
+        bulkio::OutFloatPort *csd_dataFloat_out;
+        /// Port: coherence_dataFloat_out
+        bulkio::OutFloatPort *coherence_dataFloat_out;
+        /// Port: occupancy_dataFloat_out
+        bulkio::OutFloatPort *occupancy_dataFloat_out;
+        /// Port: peaks_dataDouble_out
+        bulkio::OutDoublePort *peaks_dataDouble_out;
+        /// Port: acf_dataFloat_out
+        bulkio::OutFloatPort *acf_dataFloat_out;
+        /// Port: bands_dataFloat_out
+        bulkio::OutFloatPort *bands_dataFloat_out;
+        /// Port: fft_dataShort_out
+        bulkio::OutShortPort *fft_dataShort_out;
 
     private:
 };
@@ -20,19 +20,17 @@ License:        None
 Source0:        %{name}-%{version}.tar.gz
 BuildRoot:      %{_tmppath}/%{name}-%{version}-%{release}-root-%(%{__id_u} -n)
 
-BuildRequires:  redhawk-devel >= 2.0
-Requires:       redhawk >= 2.0
+BuildRequires:  redhawk-devel >= 2.1
+Requires:       redhawk >= 2.1
 
-BuildRequires:  rh.dsp-devel
-Requires:       rh.dsp
-BuildRequires:  rh.fftlib-devel
-Requires:       rh.fftlib
+BuildRequires:  fftw-devel
+Requires:       fftw
 BuildRequires:  RFNoC_RH-devel
 Requires:       RFNoC_RH
 
 # Interface requirements
-BuildRequires:  bulkioInterfaces >= 2.0
-Requires:       bulkioInterfaces >= 2.0
+BuildRequires:  bulkioInterfaces >= 2.1
+Requires:       bulkioInterfaces >= 2.1
 
 
 %description
@@ -86,6 +84,7 @@ rm -rf $RPM_BUILD_ROOT
 %dir %{_sdrroot}/dom/components/rh/psd
 %{_prefix}/dom/components/rh/psd/psd.scd.xml
 %{_prefix}/dom/components/rh/psd/psd.prf.xml
+%{_prefix}/dom/components/rh/psd/psd_cpp.prf.xml
 %{_prefix}/dom/components/rh/psd/psd.spd.xml
 %{_prefix}/dom/components/rh/psd/cpp
 %{_prefix}/dom/components/rh/psd/cpp_rfnoc
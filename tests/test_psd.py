@@ -22,6 +22,7 @@ import os
 from omniORB import any
 import time
 from ossie.utils import sb
+from bulkio.bulkioInterfaces import BULKIO
 try:
     from pylab import figure, plot, grid, show, title
 except ImportError:
@@ -32,6 +33,8 @@ import scipy.fftpack
 import numpy as np
 import types
 import random
+import tempfile
+import shutil
 
 DEBUG_LEVEL=3
 
@@ -79,6 +82,10 @@ def unpackCx(data):
         out.append(float(val.imag))
     return out
 
+def timestamp(seconds):
+    whole = int(seconds)
+    return BULKIO.PrecisionUTCTime(BULKIO.TCM_CPU, BULKIO.TCS_VALID, 0.0, whole, seconds-whole)
+
 def plotFreqData(fftSize, sampleRate, pyFFT, fftOut, psdOut):
     if figure:
         freqs = linspace(0,1,fftSize/2) * (sampleRate/2)
@@ -918,6 +925,677 @@ class ComponentTests(ossie.utils.testing.ScaComponentTestCase):
         self.validateSRIPushing(ID, cxData, sample_rate, fftSize, colRfVal, SRIKeywords = keywords)
         
         print "*PASSED"
+
+    def testHistoryExport(self):
+        print "\n-------- TESTING History Export --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "historyExport"
+        fftSize = 1024
+        numFrames = 8
+        historyDir = tempfile.mkdtemp()
+        self.comp.fftSize = fftSize
+        self.comp.historyDirectory = historyDir
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numFrames)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(psdOut), numFrames)
+
+        # Export the last hour of history
+        exportFile = os.path.join(historyDir, 'export.tmp')
+        self.comp.historyReplay = {'historyReplay::streamID':ID,
+                                   'historyReplay::startTime':-3600.0,
+                                   'historyReplay::stopTime':0.0,
+                                   'historyReplay::exportFile':exportFile}
+        time.sleep(.5)
+
+        try:
+            self.assertTrue(os.path.exists(exportFile))
+            subsize = fftSize/2+1
+            self.assertEqual(os.path.getsize(exportFile), 512+numFrames*subsize*4)
+        finally:
+            shutil.rmtree(historyDir)
+
+        print "*PASSED"
+
+    def testResolutions(self):
+        print "\n-------- TESTING Multiple Resolutions --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "resolutions"
+        fftSize = 1024
+        fineSize = 4096
+        numFrames = 8
+        self.comp.fftSize = fftSize
+        self.comp.resolutions = [{'resolutions::fftSize':fineSize,
+                                  'resolutions::overlap':0,
+                                  'resolutions::numAvg':0}]
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numFrames)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # Both resolutions come out of the same port on separate streams
+        psdOut = self.psdsink.getData()
+        coarse = [frame for frame in psdOut if len(frame) == fftSize/2+1]
+        fine = [frame for frame in psdOut if len(frame) == fineSize/2+1]
+        self.assertEqual(len(coarse), numFrames)
+        self.assertEqual(len(fine), fftSize*numFrames/fineSize)
+
+        print "*PASSED"
     
+    def testSparseBins(self):
+        print "\n-------- TESTING Sparse Bins --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "sparseBins"
+        fftSize = 1024
+        numFrames = 4
+        bins = [10, 100, 300]
+        self.comp.fftSize = fftSize
+        self.comp.sparseBins = bins
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numFrames)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(psdOut), numFrames)
+        self.assertEqual(len(psdOut[0]), len(bins))
+
+        # Only the requested bins of the full transform are output
+        expected = abs(scipy.fftpack.fft(data[:fftSize]))**2
+        for i, b in enumerate(bins):
+            self.assert_isclose(psdOut[0][i], expected[b], 4, 2)
+
+        sri = self.psdsink.sri()
+        self.assertEqual(sri.subsize, len(bins))
+        keywords = dict((kw.id, any.from_any(kw.value)) for kw in sri.keywords)
+        self.assertEqual(len(keywords['SPARSE_FREQUENCIES']), len(bins))
+        self.assert_isclose(keywords['SPARSE_FREQUENCIES'][1], 100*sample_rate/fftSize, PRECISION, NUM_PLACES)
+
+        print "*PASSED"
+
+    def testCrossSpectral(self):
+        print "\n-------- TESTING Cross-Spectral Density --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        csdsink = sb.DataSink()
+        cohsink = sb.DataSink()
+        self.comp.connect(csdsink, usesPortName='csd_dataFloat_out')
+        self.comp.connect(cohsink, usesPortName='coherence_dataFloat_out')
+        sb.start()
+        fftSize = 1024
+        numAvg = 4
+        self.comp.fftSize = fftSize
+        self.comp.numAvg = numAvg
+        self.comp.crossSpectralStreams = ['first', 'second']
+
+        #------------------------------------------------
+        # Create a test signal.
+        #------------------------------------------------
+        # the second stream is the first scaled by 2, on the same time stamps
+        sample_rate = 65536.
+        first = [random.random() for _ in xrange(fftSize*numAvg)]
+        second = [2*x for x in first]
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        start = time.time()
+        self.src.push(first, streamID='first', sampleRate=sample_rate, complexData=False, ts=timestamp(start))
+        self.src.push(second, streamID='second', sampleRate=sample_rate, complexData=False, ts=timestamp(start))
+        time.sleep(.5)
+
+        # Each stream still gets its own psd
+        psdOut = sorted(self.psdsink.getData(), key=sum)
+        self.assertEqual(len(psdOut), 2)
+        psdFirst = psdOut[0]
+
+        csdOut = csdsink.getData()
+        cohOut = cohsink.getData()
+        self.assertEqual(len(csdOut), 1)
+        self.assertEqual(len(cohOut), 1)
+        self.assertEqual(csdsink.sri().streamID, 'first_x_second')
+        self.assertEqual(len(cohOut[0]), fftSize/2+1)
+
+        # Fully correlated: the coherence is 1 and the cross-spectrum is twice
+        # the psd of the first stream
+        csdMag = packCx(csdOut[0])
+        for i in xrange(1, fftSize/2):
+            self.assert_isclose(cohOut[0][i], 1.0, 4, 4)
+            self.assert_isclose(csdMag[i], 2*psdFirst[i], 4, 2)
+
+        # The group keeps going until every stream has ended; data on the
+        # remaining stream can no longer be aligned and gives no output
+        self.src.push([], EOS=True, streamID='first', sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+        self.assertFalse(csdsink.eos())
+        self.src.push(second, streamID='second', sampleRate=sample_rate, complexData=False,
+                      ts=timestamp(start+len(second)/sample_rate))
+        time.sleep(.5)
+        self.assertEqual(len(csdsink.getData()), 0)
+        self.assertEqual(len(self.psdsink.getData()), 1)
+
+        self.src.push([], EOS=True, streamID='second', sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+        self.assertTrue(csdsink.eos())
+        self.assertTrue(cohsink.eos())
+
+        print "*PASSED"
+
+    def testSlidingDft(self):
+        print "\n-------- TESTING High Overlap (Sliding DFT) --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "slidingDft"
+        fftSize = 256
+        stride = 8
+        numFrames = 32
+        self.comp.fftSize = fftSize
+        self.comp.overlap = fftSize-stride
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize+stride*(numFrames-1))]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # Whether the spectrum is slid along or transformed anew, every frame
+        # is the psd of the fftSize samples starting stride after the last
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(psdOut), numFrames)
+        for frame in (0, numFrames/2, numFrames-1):
+            start = frame*stride
+            expected = abs(scipy.fftpack.fft(data[start:start+fftSize]))**2
+            for i in xrange(fftSize/2+1):
+                self.assert_isclose(psdOut[frame][i], expected[i], 4, 2)
+
+        self.assertAlmostEqual(self.psdsink.sri().ydelta, stride/sample_rate)
+
+        print "*PASSED"
+
+    def testPackedReal(self):
+        print "\n-------- TESTING Packed Real FFT --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "packedReal"
+        fftSize = 1024
+        numFrames = 4
+        self.comp.fftSize = fftSize
+        self.comp.packedRealFft = True
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numFrames)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # Both frames of each pair come out as if transformed on their own
+        fftOut = self.fftsink.getData()
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(fftOut), numFrames)
+        self.assertEqual(len(psdOut), numFrames)
+        for frame in xrange(numFrames):
+            expected = scipy.fftpack.fft(data[frame*fftSize:(frame+1)*fftSize])
+            fftMag = packCx(fftOut[frame])
+            for i in xrange(fftSize/2+1):
+                self.assert_isclose(fftMag[i], abs(expected[i]), 4, 3)
+                self.assert_isclose(psdOut[frame][i], abs(expected[i])**2, 4, 2)
+
+        self.validateSRIPushing(ID, False, sample_rate, fftSize)
+
+        print "*PASSED"
+
+    def testBatching(self):
+        print "\n-------- TESTING Batched FFTs --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "batching"
+        fftSize = 256
+        numFrames = 8
+        self.comp.fftSize = fftSize
+        self.comp.batchSize = 4
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numFrames)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # Batching changes how the frames are transformed, not the output
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(psdOut), numFrames)
+        for frame in xrange(numFrames):
+            expected = abs(scipy.fftpack.fft(data[frame*fftSize:(frame+1)*fftSize]))**2
+            for i in xrange(fftSize/2+1):
+                self.assert_isclose(psdOut[frame][i], expected[i], 4, 2)
+
+        print "*PASSED"
+
+    def testOutputAggregation(self):
+        print "\n-------- TESTING Output Aggregation --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "aggregation"
+        fftSize = 1024
+        numFrames = 8
+        framesPerPacket = 4
+        self.comp.fftSize = fftSize
+        self.comp.outputAggregation = framesPerPacket
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numFrames)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # The frames arrive framesPerPacket to a packet, in order and unchanged
+        psdOut, tstamps = self.psdsink.getData(tstamps=True)
+        self.assertEqual(len(psdOut), numFrames)
+        self.assertEqual(len(tstamps), numFrames/framesPerPacket)
+        for frame in (0, framesPerPacket-1, numFrames-1):
+            expected = abs(scipy.fftpack.fft(data[frame*fftSize:(frame+1)*fftSize]))**2
+            for i in xrange(fftSize/2+1):
+                self.assert_isclose(psdOut[frame][i], expected[i], 4, 2)
+
+        sri = self.psdsink.sri()
+        self.assertEqual(sri.subsize, fftSize/2+1)
+        self.assertAlmostEqual(sri.ydelta, fftSize/sample_rate)
+
+        print "*PASSED"
+
+    def testMedianAveraging(self):
+        print "\n-------- TESTING Median Averaging --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "medianAveraging"
+        fftSize = 1024
+        numAvg = 3
+        self.comp.fftSize = fftSize
+        self.comp.numAvg = numAvg
+        self.comp.averaging = 'median'
+
+        #------------------------------------------------
+        # Create a test signal.
+        #------------------------------------------------
+        # noise, with a strong burst in the middle frame only
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numAvg)]
+        for n in xrange(fftSize, 2*fftSize):
+            data[n] += 100.0*cos(2*pi*100*n/fftSize)
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # The median of three frames is exact, and the burst does not show
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(psdOut), 1)
+        frames = [abs(scipy.fftpack.fft(data[f*fftSize:(f+1)*fftSize]))**2 for f in xrange(numAvg)]
+        expected = np.median(frames, axis=0)
+        for i in xrange(fftSize/2+1):
+            self.assert_isclose(psdOut[0][i], expected[i], 4, 2)
+        self.assertTrue(psdOut[0][100] < 0.01*frames[1][100])
+
+        print "*PASSED"
+
+    def testMultitaper(self):
+        print "\n-------- TESTING Multitaper PSD --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "multitaper"
+        fftSize = 1024
+        self.comp.fftSize = fftSize
+        self.comp.multitaperTapers = 3
+        self.comp.multitaperBandwidth = 2.0
+
+        #------------------------------------------------
+        # Create a test signal.
+        #------------------------------------------------
+        # a tone halfway between bins 100 and 101, which leaks across the
+        # whole periodogram
+        sample_rate = 65536.
+        data = [cos(2*pi*100.5*n/fftSize) for n in xrange(fftSize)]
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(psdOut), 1)
+        psd = psdOut[0]
+        periodogram = abs(scipy.fftpack.fft(data))**2
+
+        # The tapers keep the total power and the peak, but confine the
+        # tone to a few bins either side of it
+        self.assert_isclose(sum(psd[1:fftSize/2]), sum(periodogram[1:fftSize/2]), 2, 2)
+        self.assertTrue(psd.index(max(psd)) in (100, 101))
+        self.assertTrue(psd[130] < 0.01*periodogram[130])
+
+        print "*PASSED"
+
+    def testMaxOutputRate(self):
+        print "\n-------- TESTING Max Output Rate --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "maxOutputRate"
+        fftSize = 1024
+        numFrames = 16
+        self.comp.fftSize = fftSize
+        self.comp.maxOutputRate = 16.0
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [random.random() for _ in xrange(fftSize*numFrames)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # 64 frames per second are averaged 4 at a time to stay at 16 per
+        # second; the fft output is not limited
+        fftOut = self.fftsink.getData()
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(fftOut), numFrames)
+        self.assertEqual(len(psdOut), numFrames/4)
+        self.assertAlmostEqual(self.psdsink.sri().ydelta, 4*fftSize/sample_rate)
+        self.assertAlmostEqual(self.fftsink.sri().ydelta, fftSize/sample_rate)
+
+        frames = [abs(scipy.fftpack.fft(data[f*fftSize:(f+1)*fftSize]))**2 for f in xrange(4)]
+        expected = np.mean(frames, axis=0)
+        for i in xrange(fftSize/2+1):
+            self.assert_isclose(psdOut[0][i], expected[i], 4, 2)
+
+        print "*PASSED"
+
+    def testOccupancy(self):
+        print "\n-------- TESTING Occupancy --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        occupancysink = sb.DataSink()
+        self.comp.connect(occupancysink, usesPortName='occupancy_dataFloat_out')
+        sb.start()
+        ID = "occupancy"
+        fftSize = 1024
+        numFrames = 8
+        sample_rate = 65536.
+        self.comp.fftSize = fftSize
+        self.comp.occupancyThreshold = 1.0
+        self.comp.occupancyInterval = numFrames*fftSize/sample_rate
+
+        #------------------------------------------------
+        # Create a test signal.
+        #------------------------------------------------
+        # a tone in bin 100 for the first half of the frames only
+        data = [5.0*cos(2*pi*100*n/fftSize) for n in xrange(fftSize*numFrames/2)]
+        data += [0.0]*(fftSize*numFrames/2)
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        occupancyOut = occupancysink.getData()
+        self.assertEqual(len(occupancyOut), 1)
+        self.assertEqual(len(occupancyOut[0]), fftSize/2+1)
+        self.assert_isclose(occupancyOut[0][100], 0.5, PRECISION, NUM_PLACES)
+        self.assert_isclose(occupancyOut[0][300], 0.0, PRECISION, NUM_PLACES)
+        self.assertAlmostEqual(occupancysink.sri().ydelta, numFrames*fftSize/sample_rate)
+
+        print "*PASSED"
+
+    def testPeaks(self):
+        print "\n-------- TESTING Peak Output --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        peaksink = sb.DataSink()
+        self.comp.connect(peaksink, usesPortName='peaks_dataDouble_out')
+        sb.start()
+        ID = "peaks"
+        fftSize = 1024
+        self.comp.fftSize = fftSize
+        self.comp.peakCount = 2
+
+        #------------------------------------------------
+        # Create a test signal.
+        #------------------------------------------------
+        # tones of amplitude 3 in bin 200 and 5 in bin 100, with a weaker
+        # one in bin 300 that is not reported
+        sample_rate = 65536.
+        data = [3.0*cos(2*pi*200*n/fftSize) + 5.0*cos(2*pi*100*n/fftSize) + cos(2*pi*300*n/fftSize)
+                for n in xrange(fftSize)]
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # [frequency, power] pairs, strongest first
+        peakOut = peaksink.getData()
+        self.assertEqual(len(peakOut), 2)
+        binWidth = sample_rate/fftSize
+        self.assert_isclose(peakOut[0][0], 100*binWidth, PRECISION, 3)
+        self.assert_isclose(peakOut[0][1], (5.0*fftSize/2)**2, 4, 2)
+        self.assert_isclose(peakOut[1][0], 200*binWidth, PRECISION, 3)
+        self.assert_isclose(peakOut[1][1], (3.0*fftSize/2)**2, 4, 2)
+        self.assertEqual(peaksink.sri().subsize, 2)
+
+        print "*PASSED"
+
+    def testChangeOnly(self):
+        print "\n-------- TESTING Change-Only Output --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        sb.start()
+        ID = "changeOnly"
+        fftSize = 1024
+        numFrames = 8
+        self.comp.fftSize = fftSize
+        self.comp.changeThreshold = 1.0
+
+        #------------------------------------------------
+        # Create a test signal.
+        #------------------------------------------------
+        # the same frame over and over, then one 10 dB stronger
+        sample_rate = 65536.
+        frame = [random.random() for _ in xrange(fftSize)]
+        data = frame*numFrames + [x*10**0.5 for x in frame]
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        # Only the first frame and the changed one are sent; the fft output
+        # is not affected
+        psdOut = self.psdsink.getData()
+        self.assertEqual(len(psdOut), 2)
+        self.assertEqual(len(self.fftsink.getData()), numFrames+1)
+        self.assertEqual(self.comp.suppressedFrames, numFrames-1)
+        expected = abs(scipy.fftpack.fft(frame))**2
+        for i in xrange(fftSize/2+1):
+            self.assert_isclose(psdOut[1][i], 10*expected[i], 4, 2)
+
+        print "*PASSED"
+
+    def testBandPower(self):
+        print "\n-------- TESTING Band Power --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        bandsink = sb.DataSink()
+        self.comp.connect(bandsink, usesPortName='bands_dataFloat_out')
+        sb.start()
+        ID = "bandPower"
+        fftSize = 1024
+        self.comp.fftSize = fftSize
+        # bins are 64 Hz apart; the last band is above the output and dropped
+        self.comp.bands = [{'bands::name':'low', 'bands::startFrequency':6000.0, 'bands::stopFrequency':6800.0},
+                           {'bands::name':'high', 'bands::startFrequency':20000.0, 'bands::stopFrequency':21000.0},
+                           {'bands::name':'above', 'bands::startFrequency':40000.0, 'bands::stopFrequency':41000.0}]
+
+        #------------------------------------------------
+        # Create a test signal.
+        #------------------------------------------------
+        # tones of amplitude 5 in bin 100 (6400 Hz) and 2 in bin 320 (20480 Hz)
+        sample_rate = 65536.
+        data = [5.0*cos(2*pi*100*n/fftSize) + 2.0*cos(2*pi*320*n/fftSize) for n in xrange(fftSize)]
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        bandOut = bandsink.getData()
+        self.assertEqual(len(bandOut), 1)
+        self.assertEqual(len(bandOut[0]), 2)
+        self.assert_isclose(bandOut[0][0], (5.0*fftSize/2)**2, 4, 2)
+        self.assert_isclose(bandOut[0][1], (2.0*fftSize/2)**2, 4, 2)
+
+        keywords = dict((kw.id, any.from_any(kw.value)) for kw in bandsink.sri().keywords)
+        self.assertEqual(list(keywords['BAND_NAMES']), ['low', 'high'])
+
+        print "*PASSED"
+
+    def testBlockFloatFft(self):
+        print "\n-------- TESTING 16-bit Block Floating Point FFT --------"
+        #---------------------------------
+        # Start component and set fftSize
+        #---------------------------------
+        shortsink = sb.DataSink()
+        self.comp.connect(shortsink, usesPortName='fft_dataShort_out')
+        sb.start()
+        ID = "blockFloat"
+        fftSize = 1024
+        self.comp.fftSize = fftSize
+
+        #------------------------------------------------
+        # Test Component Functionality.
+        #------------------------------------------------
+        # Push Data
+        sample_rate = 65536.
+        data = [1000.0*random.random() for _ in xrange(fftSize)]
+        self.src.push(data, streamID=ID, sampleRate=sample_rate, complexData=False)
+        time.sleep(.5)
+
+        fftOut = self.fftsink.getData()[0]
+        shortOut = shortsink.getData()
+        self.assertEqual(len(shortOut), 1)
+        self.assertEqual(len(shortOut[0]), 2*(fftSize/2+2))
+
+        # The mantissas scaled by 2^e give back the float fft to within the
+        # 16-bit resolution of the frame's largest value
+        exponent = shortOut[0][0]
+        mantissas = shortOut[0][2:]
+        peak = max(abs(x) for x in fftOut)
+        self.assertTrue(max(abs(x) for x in mantissas) >= 2**14)
+        for i in xrange(len(fftOut)):
+            self.assertTrue(abs(mantissas[i]*2.0**exponent - fftOut[i]) <= peak*2**-14)
+
+        sri = shortsink.sri()
+        self.assertAlmostEqual(sri.xstart, -sample_rate/fftSize)
+        self.assertEqual(sri.subsize, fftSize/2+2)
+
+        print "*PASSED"
+
+    def testBatchPackedRealJobs(self):
+        print "\n-------- TESTING psd_batch Packed Real Job Count --------"
+        batch = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'cpp', 'psd_batch')
+        if not os.path.exists(batch):
+            print "psd_batch not built, skipping"
+            return
+        import subprocess
+        fftSize = 256
+        # an odd number of frames per segment for some job counts
+        numFrames = 37
+        workDir = tempfile.mkdtemp()
+        try:
+            inputFile = os.path.join(workDir, 'input.tmp')
+            np.array([random.random() for _ in xrange(fftSize*numFrames)], dtype=np.float32).tofile(inputFile)
+            outputs = []
+            for jobs in (1, 3, 5):
+                outDir = os.path.join(workDir, 'j%d' % jobs)
+                os.mkdir(outDir)
+                ret = subprocess.call([batch, '-n', str(fftSize), '-P', '-j', str(jobs), '-d', outDir, inputFile])
+                self.assertEqual(ret, 0)
+                outputs.append(open(os.path.join(outDir, 'input.tmp.psd'), 'rb').read())
+            self.assertEqual(outputs[1], outputs[0])
+            self.assertEqual(outputs[2], outputs[0])
+        finally:
+            shutil.rmtree(workDir)
+
+        print "*PASSED"
+
 if __name__ == "__main__":
     ossie.utils.testing.main("../psd.spd.xml") # By default tests all implementations